@@ -0,0 +1 @@
+../lib/conformance.c
\ No newline at end of file
@@ -0,0 +1 @@
+../lib/conformance.h
\ No newline at end of file
@@ -0,0 +1,87 @@
+/*
+
+MIT License
+
+Copyright (c) 2023 Urban Hafner
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include <stdlib.h>
+#include <time.h>
+
+#include "conformance.h"
+#include "genann.h"
+
+#define POSITIONS 64
+#define SECONDS 0.2
+#define RANDOM_NETS 5
+
+pcg32_random_t rng;
+
+// Returns the number of paths that picked a different move than genann_run
+int check(genann *ann) {
+  conformance_result results[conformance_paths()];
+  int failed = 0;
+
+  conformance_check(ann, POSITIONS, SECONDS, results);
+  conformance_print(stdout, ann, results);
+  for (int p = 0; p < conformance_paths(); p++) {
+    if (results[p].disagreement > 0) failed++;
+  }
+  return failed;
+}
+
+int main(int argc, char **argv) {
+  pcg32_srandom(time(NULL), (intptr_t)&rng);
+
+  // Do not buffer stdout
+  setbuf(stdout, NULL);
+
+  int failed = 0;
+
+  if (argc > 1) {
+    for (int i = 1; i < argc; i++) {
+      FILE *fd = fopen(argv[i], "rb");
+      if (fd == NULL) {
+        perror(argv[i]);
+        exit(1);
+      }
+      genann *ann = genann_binary_read(fd);
+      fclose(fd);
+      if (ann == NULL) exit(1);
+
+      printf("%s: ", argv[i]);
+      failed += check(ann);
+      genann_free(ann);
+    }
+  } else {
+    for (int i = 0; i < RANDOM_NETS; i++) {
+      genann *ann = conformance_random_ann(200, 3, 200, 200);
+      failed += check(ann);
+      genann_free(ann);
+    }
+  }
+
+  if (failed) {
+    printf("%d paths disagree with genann_run!\n", failed);
+    exit(1);
+  }
+}
@@ -0,0 +1 @@
+../lib/genann.c
\ No newline at end of file
@@ -0,0 +1 @@
+../lib/genann.h
\ No newline at end of file
@@ -0,0 +1,208 @@
+/*
+
+MIT License
+
+Copyright (c) 2023 Urban Hafner
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "genann.h"
+
+#define MAX_BATCH 32
+#define MIN_SECONDS 0.2
+// Prefer the smaller batch unless the bigger one is at least this much faster
+#define BATCH_MARGIN 0.05
+
+pcg32_random_t rng;
+
+static const int tiles[] = {1, 2, 4, 8};
+static const int batches[] = {1, 2, 4, 8, 16, 32};
+
+double now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Board like inputs: komi first, then stones as -1, 0 or 1
+void random_inputs(genann *ann, double *inputs, int n) {
+  for (int b = 0; b < n; b++) {
+    double *in = inputs + b * ann->inputs;
+    in[0] = 6.5;
+    for (int k = 1; k < ann->inputs; k++) in[k] = (double)pcg32_boundedrand(3) - 1.0;
+  }
+}
+
+// Seconds per position when running the inputs one by one
+double time_tiled(genann *ann, double *inputs, int n) {
+  long runs = 0;
+  double start = now(), elapsed;
+  do {
+    genann_run_tiled(ann, inputs + (runs % n) * ann->inputs);
+    runs++;
+    elapsed = now() - start;
+  } while (elapsed < MIN_SECONDS);
+  return elapsed / runs;
+}
+
+// Seconds per position when running the inputs batch at a time
+double time_batch(genann *ann, double *inputs, double *outputs, int batch) {
+  long runs = 0;
+  double start = now(), elapsed;
+  do {
+    genann_run_batch(ann, batch, inputs, outputs);
+    runs++;
+    elapsed = now() - start;
+  } while (elapsed < MIN_SECONDS);
+  return elapsed / (runs * batch);
+}
+
+void report(const char *name, int value, genann *ann, double seconds) {
+  printf(
+    "%-6s %3d  %10.1f us/position  %6.3f ns/weight  %6.2f GB/s\n",
+    name,
+    value,
+    seconds * 1e6,
+    seconds * 1e9 / ann->total_weights,
+    ann->total_weights * sizeof(double) / seconds * 1e-9
+  );
+}
+
+// Keep every entry of the old profile except the one for this topology
+void save_profile(genann *ann, char *profile) {
+  char line[256];
+  char *kept = NULL;
+  size_t kept_size = 0;
+  FILE *fd = fopen(profile, "r");
+
+  if (fd != NULL) {
+    FILE *mem = open_memstream(&kept, &kept_size);
+    while (fgets(line, sizeof(line), fd)) {
+      int inputs, hidden_layers, hidden, outputs;
+      if (line[0] != '#'
+          && sscanf(line, "%d %d %d %d", &inputs, &hidden_layers, &hidden, &outputs) == 4
+          && inputs == ann->inputs && hidden_layers == ann->hidden_layers
+          && hidden == ann->hidden && outputs == ann->outputs)
+        continue;
+      fputs(line, mem);
+    }
+    fclose(mem);
+    fclose(fd);
+  }
+
+  fd = fopen(profile, "w");
+  if (fd == NULL) {
+    perror(profile);
+    exit(1);
+  }
+  if (kept_size > 0) {
+    fputs(kept, fd);
+  } else {
+    char host[64] = "unknown";
+    gethostname(host, sizeof(host));
+    fprintf(fd, "# Kernel tuning for %s\n", host);
+    fprintf(fd, "# inputs hidden_layers hidden outputs tile batch\n");
+  }
+  genann_tuning_write(ann, fd);
+  fclose(fd);
+  free(kept);
+}
+
+int main(int argc, char **argv) {
+  pcg32_srandom(time(NULL), (intptr_t)&rng);
+
+  // Do not buffer stdout
+  setbuf(stdout, NULL);
+
+  if (argc < 2 || argc > 3) {
+    fprintf(stderr, "Usage: autotune ann [profile]\n");
+    exit(1);
+  }
+
+  // Default to the same place the engine looks for the profile
+  char profile[1024];
+  char *slash = strrchr(argv[0], '/');
+  if (argc == 3)
+    snprintf(profile, sizeof(profile), "%s", argv[2]);
+  else if (slash != NULL)
+    snprintf(profile, sizeof(profile), "%.*s/tuning.profile", (int)(slash - argv[0]), argv[0]);
+  else
+    snprintf(profile, sizeof(profile), "tuning.profile");
+
+  FILE *fd = fopen(argv[1], "rb");
+  if (fd == NULL) {
+    perror(argv[1]);
+    exit(1);
+  }
+  genann *ann = genann_binary_read(fd);
+  fclose(fd);
+  if (ann == NULL) exit(1);
+
+  printf(
+    "Tuning %d inputs, %d layers, %d neurons per layer, %d outputs (%d weights)\n",
+    ann->inputs,
+    ann->hidden_layers,
+    ann->hidden,
+    ann->outputs,
+    ann->total_weights
+  );
+
+  double *inputs = malloc(MAX_BATCH * ann->inputs * sizeof(double));
+  double *outputs = malloc(MAX_BATCH * ann->outputs * sizeof(double));
+  random_inputs(ann, inputs, MAX_BATCH);
+
+  int best_tile = 1;
+  double best_time = 0;
+  for (size_t t = 0; t < sizeof(tiles) / sizeof(tiles[0]); t++) {
+    ann->tuning.tile = tiles[t];
+    double seconds = time_tiled(ann, inputs, MAX_BATCH);
+    report("tile", tiles[t], ann, seconds);
+    if (best_time == 0 || seconds < best_time) {
+      best_time = seconds;
+      best_tile = tiles[t];
+    }
+  }
+  ann->tuning.tile = best_tile;
+
+  int best_batch = 1;
+  best_time = 0;
+  for (size_t b = 0; b < sizeof(batches) / sizeof(batches[0]); b++) {
+    double seconds = time_batch(ann, inputs, outputs, batches[b]);
+    report("batch", batches[b], ann, seconds);
+    if (best_time == 0 || seconds < best_time * (1.0 - BATCH_MARGIN)) {
+      best_time = seconds;
+      best_batch = batches[b];
+    }
+  }
+  ann->tuning.batch = best_batch;
+
+  printf("Best: tile %d, batch %d. Saving to %s\n", best_tile, best_batch, profile);
+  save_profile(ann, profile);
+
+  free(inputs);
+  free(outputs);
+  genann_free(ann);
+}
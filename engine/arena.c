@@ -0,0 +1,178 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * This is Evo, a simple go program.                             *
+ *                                                               *
+ * Copyright 2023 by Urban Hafner                                *
+ *           2003 and 2004 by Gunnar Farnebäck.                  *
+ *                                                               *
+ * Permission is hereby granted, free of charge, to any person   *
+ * obtaining a copy of this file gtp.c, to deal in the Software  *
+ * without restriction, including without limitation the rights  *
+ * to use, copy, modify, merge, publish, distribute, and/or      *
+ * sell copies of the Software, and to permit persons to whom    *
+ * the Software is furnished to do so, provided that the above   *
+ * copyright notice(s) and this permission notice appear in all  *
+ * copies of the Software and that both the above copyright      *
+ * notice(s) and this permission notice appear in supporting     *
+ * documentation.                                                *
+ *                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY     *
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE    *
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR       *
+ * PURPOSE AND NONINFRINGEMENT OF THIRD PARTY RIGHTS. IN NO      *
+ * EVENT SHALL THE COPYRIGHT HOLDER OR HOLDERS INCLUDED IN THIS  *
+ * NOTICE BE LIABLE FOR ANY CLAIM, OR ANY SPECIAL INDIRECT OR    *
+ * CONSEQUENTIAL DAMAGES, OR ANY DAMAGES WHATSOEVER RESULTING    *
+ * FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF    *
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT    *
+ * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS       *
+ * SOFTWARE.                                                     *
+ *                                                               *
+ * Except as contained in this notice, the name of a copyright   *
+ * holder shall not be used in advertising or otherwise to       *
+ * promote the sale, use or other dealings in this Software      *
+ * without prior written authorization of the copyright holder.  *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "brown.h"
+#include "generate_move.h"
+#include "match.h"
+
+/* Games between nets without GTP, a referee or any process per game.
+ *
+ * The nets are given in pairs, black first, and every pair plays one
+ * game. Games between nets are deterministic, so a rematch with the
+ * same colors would only repeat it. Each net is loaded once, however
+ * often it plays. Every game is written the way gogui-twogtp writes
+ * it, as <black>x<white>R<round>.dat with the result in the last line
+ * and <black>x<white>R<round>-0.sgf, where black and white are the
+ * file names of the nets without extension.
+ */
+
+pcg32_random_t rng;
+
+static void
+usage(void)
+{
+  fprintf(stderr, "Usage: arena [--size n] [--komi k] [--maxmoves n] [--round r] black.ann white.ann ...\n");
+  exit(1);
+}
+
+static double
+now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static genann *
+load_net(const char *path)
+{
+  genann *net;
+  FILE *fd = fopen(path, "rb");
+
+  if (fd == NULL) {
+    perror(path);
+    exit(1);
+  }
+  net = genann_binary_read(fd);
+  fclose(fd);
+  if (net == NULL)
+    exit(1);
+  return net;
+}
+
+int
+main(int argc, char **argv)
+{
+  int size = 9, max_moves = 0, round = 0;
+  float komi = 6.5;
+  genann **nets;
+  player_t *players;
+  int *moves;
+  board_t game;
+  long total_moves = 0;
+  double start, elapsed;
+  int k, m, first_net, num_nets;
+
+  pcg32_srandom(time(NULL), (intptr_t)&rng);
+
+  for (k = 1; k < argc && !strncmp(argv[k], "--", 2); k += 2) {
+    if (k + 1 >= argc)
+      usage();
+    if (!strcmp(argv[k], "--size"))
+      size = atoi(argv[k + 1]);
+    else if (!strcmp(argv[k], "--komi"))
+      komi = atof(argv[k + 1]);
+    else if (!strcmp(argv[k], "--maxmoves"))
+      max_moves = atoi(argv[k + 1]);
+    else if (!strcmp(argv[k], "--round"))
+      round = atoi(argv[k + 1]);
+    else
+      usage();
+  }
+  first_net = k;
+  num_nets = argc - first_net;
+  if (num_nets < 2 || num_nets % 2 != 0
+      || size < MIN_BOARD || size > MAX_BOARD)
+    usage();
+  if (max_moves <= 0)
+    max_moves = 3 * size * size;
+
+  /* Load every net once, players of the same file share it. */
+  nets = malloc(num_nets * sizeof(genann *));
+  players = malloc(num_nets * sizeof(player_t));
+  for (k = 0; k < num_nets; k++) {
+    nets[k] = NULL;
+    for (m = 0; m < k; m++)
+      if (!strcmp(argv[first_net + m], argv[first_net + k]))
+	nets[k] = nets[m];
+    if (nets[k] == NULL)
+      nets[k] = load_net(argv[first_net + k]);
+    init_player(&players[k], &nets[k], 1);
+  }
+
+  init_brown(&game);
+  set_board_size(&game, size);
+  game.komi = komi;
+  moves = malloc(max_moves * sizeof(int));
+
+  start = now();
+  for (k = 0; k < num_nets; k += 2) {
+    char black[256], white[256], prefix[600];
+    game_result result;
+
+    player_name(argv[first_net + k], black, sizeof(black));
+    player_name(argv[first_net + k + 1], white, sizeof(white));
+    snprintf(prefix, sizeof(prefix), "%sx%sR%d", black, white, round);
+
+    play_game(&game, &players[k], &players[k + 1], max_moves, moves, &result);
+    if (!write_game_files(prefix, &game, black, white, moves, &result))
+      exit(1);
+    total_moves += result.moves;
+  }
+  elapsed = now() - start;
+
+  fprintf(stderr, "%d games, %ld moves in %.2f s: %.1f games/s, %.0f moves/s\n",
+	  num_nets / 2, total_moves, elapsed, num_nets / 2 / elapsed,
+	  total_moves / elapsed);
+
+  for (k = 0; k < num_nets; k++) {
+    free_player(&players[k]);
+    for (m = 0; m < k; m++)
+      if (nets[m] == nets[k])
+	break;
+    if (m == k)
+      genann_free(nets[k]);
+  }
+  free(nets);
+  free(players);
+  free(moves);
+  free_brown(&game);
+  return 0;
+}
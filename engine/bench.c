@@ -0,0 +1,328 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * This is Evo, a simple go program.                             *
+ *                                                               *
+ * Copyright 2023 by Urban Hafner                                *
+ *           2003 and 2004 by Gunnar Farnebäck.                  *
+ *                                                               *
+ * Permission is hereby granted, free of charge, to any person   *
+ * obtaining a copy of this file gtp.c, to deal in the Software  *
+ * without restriction, including without limitation the rights  *
+ * to use, copy, modify, merge, publish, distribute, and/or      *
+ * sell copies of the Software, and to permit persons to whom    *
+ * the Software is furnished to do so, provided that the above   *
+ * copyright notice(s) and this permission notice appear in all  *
+ * copies of the Software and that both the above copyright      *
+ * notice(s) and this permission notice appear in supporting     *
+ * documentation.                                                *
+ *                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY     *
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE    *
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR       *
+ * PURPOSE AND NONINFRINGEMENT OF THIRD PARTY RIGHTS. IN NO      *
+ * EVENT SHALL THE COPYRIGHT HOLDER OR HOLDERS INCLUDED IN THIS  *
+ * NOTICE BE LIABLE FOR ANY CLAIM, OR ANY SPECIAL INDIRECT OR    *
+ * CONSEQUENTIAL DAMAGES, OR ANY DAMAGES WHATSOEVER RESULTING    *
+ * FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF    *
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT    *
+ * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS       *
+ * SOFTWARE.                                                     *
+ *                                                               *
+ * Except as contained in this notice, the name of a copyright   *
+ * holder shall not be used in advertising or otherwise to       *
+ * promote the sale, use or other dealings in this Software      *
+ * without prior written authorization of the copyright holder.  *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "brown.h"
+#include "generate_move.h"
+
+/* Benchmarks of the board code.
+ *
+ * Move selection with legal_move_mask() is timed against the loop it
+ * replaced, which checks legality, suicide and captures point by point
+ * whenever a better scoring point shows up. Positions are taken from
+ * games between random predictions, in the middle game and in the late
+ * game, and both selections must agree on every one of them.
+ *
+ * Make/unmake pairs play every move legal_move_mask() allows in the
+ * same kind of positions and take it back again, which must leave the
+ * hash as it was.
+ *
+ * Playouts play uniformly random moves from legal_move_mask() until
+ * both colors pass, which exercises the whole board code the way a
+ * search would.
+ */
+
+#define GAMES 50
+#define REPEATS 200
+#define PLAYOUT_SECONDS 1.0
+
+pcg32_random_t rng;
+
+static board_t game;
+
+static double
+now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void
+random_prediction(double *prediction, int outputs)
+{
+  int k;
+  for (k = 0; k < outputs; k++)
+    prediction[k] = ldexp(pcg32_random(), -32);
+}
+
+/* The move selection before legal_move_mask(). */
+static void
+reference_best_move(int *i, int *j, int color, const double *prediction)
+{
+  int points = game.board_size * game.board_size;
+  int pred_index, ai, aj, k;
+  int best_index = -1;
+
+  for (pred_index = 0; pred_index < points; pred_index++) {
+    if (best_index == -1 || prediction[pred_index] > prediction[best_index]) {
+      ai = I(&game, pred_index);
+      aj = J(&game, pred_index);
+      if (legal_move(&game, ai, aj, color) && !suicide(&game, ai, aj, color)) {
+	if (!suicide(&game, ai, aj, OTHER_COLOR(color)))
+	  best_index = pred_index;
+	else
+	  for (k = 0; k < 4; k++) {
+	    int bi = ai + deltai[k];
+	    int bj = aj + deltaj[k];
+	    if (on_board(&game, bi, bj) && get_board(&game, bi, bj) == OTHER_COLOR(color)) {
+	      best_index = pred_index;
+	      break;
+	    }
+	  }
+      }
+    }
+  }
+
+  if (best_index != -1 && prediction[best_index] > prediction[points]) {
+    *i = I(&game, best_index);
+    *j = J(&game, best_index);
+  }
+  else {
+    *i = -1;
+    *j = -1;
+  }
+}
+
+/* Play to the position after moves random moves of a game. Returns
+ * the color to move.
+ */
+static int
+random_position(double *predictions, int outputs, int moves)
+{
+  int color = BLACK;
+  int m;
+
+  clear_board(&game);
+  for (m = 0; m < moves; m++) {
+    int i, j;
+    random_prediction(predictions, outputs);
+    predictions[outputs - 1] = 0;
+    find_and_set_best_move(&game, &i, &j, color, predictions);
+    play_move(&game, i, j, color);
+    color = OTHER_COLOR(color);
+  }
+  return color;
+}
+
+/* Time both move selections on the position reached after moves
+ * random moves of every game. Returns the number of disagreements.
+ */
+static int
+bench_selection(int size, int moves, const char *stage)
+{
+  int outputs = size * size + 1;
+  double *predictions = malloc(REPEATS * outputs * sizeof(double));
+  double reference_time = 0, mask_time = 0;
+  int positions = 0, disagreements = 0;
+  int g, r;
+
+  set_board_size(&game, size);
+  for (g = 0; g < GAMES; g++) {
+    int color = random_position(predictions, outputs, moves);
+    int ai[REPEATS], aj[REPEATS], bi[REPEATS], bj[REPEATS];
+    double start;
+
+    for (r = 0; r < REPEATS; r++)
+      random_prediction(predictions + r * outputs, outputs);
+
+    start = now();
+    for (r = 0; r < REPEATS; r++)
+      reference_best_move(&ai[r], &aj[r], color, predictions + r * outputs);
+    reference_time += now() - start;
+
+    start = now();
+    for (r = 0; r < REPEATS; r++)
+      find_and_set_best_move(&game, &bi[r], &bj[r], color, predictions + r * outputs);
+    mask_time += now() - start;
+
+    for (r = 0; r < REPEATS; r++)
+      disagreements += ai[r] != bi[r] || aj[r] != bj[r];
+    positions += REPEATS;
+  }
+
+  printf("%2dx%-2d %-6s %8.0f ns/move before %8.0f ns/move after  %5.1fx",
+	 size, size, stage, reference_time * 1e9 / positions,
+	 mask_time * 1e9 / positions, reference_time / mask_time);
+  if (disagreements)
+    printf("  %d DISAGREEMENTS", disagreements);
+  printf("\n");
+
+  free(predictions);
+  return disagreements;
+}
+
+/* Time make/unmake pairs of every move the mask allows. Returns the
+ * number of pairs which changed the hash.
+ */
+static int
+bench_undo(int size, int moves, const char *stage)
+{
+  int outputs = size * size + 1;
+  double *predictions = malloc(outputs * sizeof(double));
+  double elapsed = 0;
+  long pairs = 0;
+  int failures = 0;
+  int g, r, pos;
+
+  set_board_size(&game, size);
+  for (g = 0; g < GAMES; g++) {
+    int color = random_position(predictions, outputs, moves);
+    uint64_t hash = board_hash(&game);
+    uint64_t mask[MOVE_MASK_WORDS];
+    int mask_moves[MAX_BOARD * MAX_BOARD];
+    int num_moves = 0;
+    double start;
+
+    legal_move_mask(&game, color, mask);
+    for (pos = 0; pos < size * size; pos++)
+      if ((mask[pos >> 6] >> (pos & 63)) & 1)
+	mask_moves[num_moves++] = pos;
+
+    start = now();
+    for (r = 0; r < REPEATS; r++)
+      for (pos = 0; pos < num_moves; pos++) {
+	play_move(&game, I(&game, mask_moves[pos]), J(&game, mask_moves[pos]), color);
+	unmake_move(&game);
+      }
+    elapsed += now() - start;
+    pairs += (long)REPEATS * num_moves;
+
+    for (pos = 0; pos < num_moves; pos++) {
+      play_move(&game, I(&game, mask_moves[pos]), J(&game, mask_moves[pos]), color);
+      unmake_move(&game);
+      failures += board_hash(&game) != hash;
+    }
+  }
+
+  printf("%2dx%-2d %-6s %8.0f ns/pair  %10.0f make/unmake pairs/s",
+	 size, size, stage, elapsed * 1e9 / pairs, pairs / elapsed);
+  if (failures)
+    printf("  %d CHANGED HASHES", failures);
+  printf("\n");
+
+  free(predictions);
+  return failures;
+}
+
+/* A random move of the mask, or pass if it is empty. */
+static void
+random_mask_move(const uint64_t *mask, int *i, int *j)
+{
+  int count = 0, pick, w, pos;
+  uint64_t word;
+
+  for (w = 0; w < MOVE_MASK_WORDS; w++)
+    count += __builtin_popcountll(mask[w]);
+  if (count == 0) {
+    *i = -1;
+    *j = -1;
+    return;
+  }
+
+  pick = pcg32_boundedrand(count);
+  for (w = 0; pick >= __builtin_popcountll(mask[w]); w++)
+    pick -= __builtin_popcountll(mask[w]);
+  for (word = mask[w]; pick > 0; pick--)
+    word &= word - 1;
+  pos = w * 64 + __builtin_ctzll(word);
+  *i = I(&game, pos);
+  *j = J(&game, pos);
+}
+
+/* Random playouts from the empty board for PLAYOUT_SECONDS. */
+static void
+bench_playouts(int size)
+{
+  long playouts = 0, moves = 0;
+  double start = now(), elapsed;
+
+  set_board_size(&game, size);
+  do {
+    int color = BLACK;
+    int passes = 0;
+    int m;
+
+    clear_board(&game);
+    for (m = 0; passes < 2 && m < 3 * size * size; m++) {
+      uint64_t mask[MOVE_MASK_WORDS];
+      int i, j;
+      legal_move_mask(&game, color, mask);
+      random_mask_move(mask, &i, &j);
+      play_move(&game, i, j, color);
+      passes = i == -1 ? passes + 1 : 0;
+      color = OTHER_COLOR(color);
+    }
+    moves += m;
+    playouts++;
+    elapsed = now() - start;
+  } while (elapsed < PLAYOUT_SECONDS);
+
+  printf("%2dx%-2d %10.0f playouts/s  %10.0f moves/s\n",
+	 size, size, playouts / elapsed, moves / elapsed);
+}
+
+int
+main(int argc, char **argv)
+{
+  static const int sizes[] = {9, 13, 19};
+  int failures = 0;
+  size_t k;
+
+  pcg32_srandom(42, 54);
+  init_brown(&game);
+
+  for (k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+    int points = sizes[k] * sizes[k];
+    failures += bench_selection(sizes[k], points / 3, "middle");
+    failures += bench_selection(sizes[k], points, "late");
+  }
+
+  for (k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+    int points = sizes[k] * sizes[k];
+    failures += bench_undo(sizes[k], points / 3, "middle");
+    failures += bench_undo(sizes[k], points, "late");
+  }
+
+  for (k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++)
+    bench_playouts(sizes[k]);
+
+  return failures != 0;
+}
@@ -0,0 +1,227 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * This is Evo, a simple go program.                             *
+ *                                                               *
+ * Copyright 2023 by Urban Hafner                                *
+ *           2003 and 2004 by Gunnar Farnebäck.                  *
+ *                                                               *
+ * Permission is hereby granted, free of charge, to any person   *
+ * obtaining a copy of this file gtp.c, to deal in the Software  *
+ * without restriction, including without limitation the rights  *
+ * to use, copy, modify, merge, publish, distribute, and/or      *
+ * sell copies of the Software, and to permit persons to whom    *
+ * the Software is furnished to do so, provided that the above   *
+ * copyright notice(s) and this permission notice appear in all  *
+ * copies of the Software and that both the above copyright      *
+ * notice(s) and this permission notice appear in supporting     *
+ * documentation.                                                *
+ *                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY     *
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE    *
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR       *
+ * PURPOSE AND NONINFRINGEMENT OF THIRD PARTY RIGHTS. IN NO      *
+ * EVENT SHALL THE COPYRIGHT HOLDER OR HOLDERS INCLUDED IN THIS  *
+ * NOTICE BE LIABLE FOR ANY CLAIM, OR ANY SPECIAL INDIRECT OR    *
+ * CONSEQUENTIAL DAMAGES, OR ANY DAMAGES WHATSOEVER RESULTING    *
+ * FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF    *
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT    *
+ * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS       *
+ * SOFTWARE.                                                     *
+ *                                                               *
+ * Except as contained in this notice, the name of a copyright   *
+ * holder shall not be used in advertising or otherwise to       *
+ * promote the sale, use or other dealings in this Software      *
+ * without prior written authorization of the copyright holder.  *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <stdint.h>
+
+/* Sets of board points, one bit per point. Point (i, j) is bit
+ * (i + 1) * stride + j + 1, where stride is one more than the board
+ * size. The first bit of every row and the rows above and below the
+ * board are never on the board. They form a ring of sentinels around
+ * it: every point has its four neighbours at the same offsets, inside
+ * the set, and shifting by one bit never wraps a stone around to the
+ * next row.
+ */
+#define BB_WORDS (((MAX_BOARD + 2) * (MAX_BOARD + 1) + 63) / 64)
+
+/* The operations below work on the first n words of a set. The macros
+ * without the _n pass BB_ACTIVE, which is all words unless code
+ * compiled for one board size has it defined to fewer, see
+ * brown_sized.h. Words above BB_ACTIVE are neither read nor written.
+ */
+#define BB_ACTIVE BB_WORDS
+
+typedef struct bitboard {
+  uint64_t w[BB_WORDS];
+} bitboard;
+
+/* Loop over the set bits of b, lowest first. Loops cannot be nested. */
+#define BB_FOR_EACH(b, bit)						\
+  for (int bb_k_ = 0; bb_k_ < BB_ACTIVE; bb_k_++)			\
+    for (uint64_t bb_w_ = (b)->w[bb_k_];				\
+	 bb_w_ && ((bit) = bb_k_ * 64 + __builtin_ctzll(bb_w_), 1);	\
+	 bb_w_ &= bb_w_ - 1)
+
+static inline void
+bb_clear_n(bitboard *r, int n)
+{
+  int k;
+  for (k = 0; k < n; k++)
+    r->w[k] = 0;
+}
+
+static inline int
+bb_test(const bitboard *b, int bit)
+{
+  return (b->w[bit >> 6] >> (bit & 63)) & 1;
+}
+
+static inline void
+bb_set(bitboard *r, int bit)
+{
+  r->w[bit >> 6] |= (uint64_t)1 << (bit & 63);
+}
+
+static inline void
+bb_reset(bitboard *r, int bit)
+{
+  r->w[bit >> 6] &= ~((uint64_t)1 << (bit & 63));
+}
+
+/* r = a & b */
+static inline void
+bb_and_n(bitboard *r, const bitboard *a, const bitboard *b, int n)
+{
+  int k;
+  for (k = 0; k < n; k++)
+    r->w[k] = a->w[k] & b->w[k];
+}
+
+/* r = a | b */
+static inline void
+bb_or_n(bitboard *r, const bitboard *a, const bitboard *b, int n)
+{
+  int k;
+  for (k = 0; k < n; k++)
+    r->w[k] = a->w[k] | b->w[k];
+}
+
+/* r = a & ~b */
+static inline void
+bb_andnot_n(bitboard *r, const bitboard *a, const bitboard *b, int n)
+{
+  int k;
+  for (k = 0; k < n; k++)
+    r->w[k] = a->w[k] & ~b->w[k];
+}
+
+static inline int
+bb_is_empty_n(const bitboard *b, int n)
+{
+  uint64_t any = 0;
+  int k;
+  for (k = 0; k < n; k++)
+    any |= b->w[k];
+  return any == 0;
+}
+
+static inline int
+bb_equal_n(const bitboard *a, const bitboard *b, int n)
+{
+  uint64_t diff = 0;
+  int k;
+  for (k = 0; k < n; k++)
+    diff |= a->w[k] ^ b->w[k];
+  return diff == 0;
+}
+
+static inline int
+bb_count_n(const bitboard *b, int n)
+{
+  int k, count = 0;
+  for (k = 0; k < n; k++)
+    count += __builtin_popcountll(b->w[k]);
+  return count;
+}
+
+/* Lowest set bit, or -1 if there is none. */
+static inline int
+bb_first_n(const bitboard *b, int n)
+{
+  int k;
+  for (k = 0; k < n; k++)
+    if (b->w[k])
+      return k * 64 + __builtin_ctzll(b->w[k]);
+  return -1;
+}
+
+/* r = b shifted towards higher bits, i.e. every point p of b moves to
+ * p + s. 0 < s < 64.
+ */
+static inline void
+bb_shift_up_n(bitboard *r, const bitboard *b, int s, int n)
+{
+  int k;
+  for (k = n - 1; k > 0; k--)
+    r->w[k] = (b->w[k] << s) | (b->w[k - 1] >> (64 - s));
+  r->w[0] = b->w[0] << s;
+}
+
+/* r = b shifted towards lower bits, every point p of b moves to p - s. */
+static inline void
+bb_shift_down_n(bitboard *r, const bitboard *b, int s, int n)
+{
+  int k;
+  for (k = 0; k < n - 1; k++)
+    r->w[k] = (b->w[k] >> s) | (b->w[k + 1] << (64 - s));
+  r->w[n - 1] = b->w[n - 1] >> s;
+}
+
+/* r = all points of mask directly adjacent to a point of b. */
+static inline void
+bb_neighbours_n(bitboard *r, const bitboard *b, int stride, const bitboard *mask, int n)
+{
+  bitboard t;
+  int k;
+  bb_shift_up_n(r, b, 1, n);
+  bb_shift_down_n(&t, b, 1, n);
+  bb_or_n(r, r, &t, n);
+  bb_shift_up_n(&t, b, stride, n);
+  bb_or_n(r, r, &t, n);
+  bb_shift_down_n(&t, b, stride, n);
+  for (k = 0; k < n; k++)
+    r->w[k] = (r->w[k] | t.w[k]) & mask->w[k];
+}
+
+/* r = all points of within connected to seed through points of within.
+ * The seed points themselves are always included.
+ */
+static inline void
+bb_flood_n(bitboard *r, const bitboard *seed, const bitboard *within, int stride, int n)
+{
+  bitboard grown;
+  bb_or_n(r, seed, seed, n);
+  for (;;) {
+    bb_neighbours_n(&grown, r, stride, within, n);
+    bb_or_n(&grown, &grown, r, n);
+    if (bb_equal_n(&grown, r, n))
+      return;
+    bb_or_n(r, &grown, &grown, n);
+  }
+}
+
+#define bb_clear(r) bb_clear_n(r, BB_ACTIVE)
+#define bb_and(r, a, b) bb_and_n(r, a, b, BB_ACTIVE)
+#define bb_or(r, a, b) bb_or_n(r, a, b, BB_ACTIVE)
+#define bb_andnot(r, a, b) bb_andnot_n(r, a, b, BB_ACTIVE)
+#define bb_is_empty(b) bb_is_empty_n(b, BB_ACTIVE)
+#define bb_equal(a, b) bb_equal_n(a, b, BB_ACTIVE)
+#define bb_count(b) bb_count_n(b, BB_ACTIVE)
+#define bb_first(b) bb_first_n(b, BB_ACTIVE)
+#define bb_shift_up(r, b, s) bb_shift_up_n(r, b, s, BB_ACTIVE)
+#define bb_shift_down(r, b, s) bb_shift_down_n(r, b, s, BB_ACTIVE)
+#define bb_neighbours(r, b, stride, mask) \
+  bb_neighbours_n(r, b, stride, mask, BB_ACTIVE)
+#define bb_flood(r, seed, within, stride) \
+  bb_flood_n(r, seed, within, stride, BB_ACTIVE)
@@ -0,0 +1,199 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * This is Evo, a simple go program.                             *
+ *                                                               *
+ * Copyright 2023 by Urban Hafner                                *
+ *           2003 and 2004 by Gunnar Farnebäck.                  *
+ *                                                               *
+ * Permission is hereby granted, free of charge, to any person   *
+ * obtaining a copy of this file gtp.c, to deal in the Software  *
+ * without restriction, including without limitation the rights  *
+ * to use, copy, modify, merge, publish, distribute, and/or      *
+ * sell copies of the Software, and to permit persons to whom    *
+ * the Software is furnished to do so, provided that the above   *
+ * copyright notice(s) and this permission notice appear in all  *
+ * copies of the Software and that both the above copyright      *
+ * notice(s) and this permission notice appear in supporting     *
+ * documentation.                                                *
+ *                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY     *
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE    *
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR       *
+ * PURPOSE AND NONINFRINGEMENT OF THIRD PARTY RIGHTS. IN NO      *
+ * EVENT SHALL THE COPYRIGHT HOLDER OR HOLDERS INCLUDED IN THIS  *
+ * NOTICE BE LIABLE FOR ANY CLAIM, OR ANY SPECIAL INDIRECT OR    *
+ * CONSEQUENTIAL DAMAGES, OR ANY DAMAGES WHATSOEVER RESULTING    *
+ * FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF    *
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT    *
+ * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS       *
+ * SOFTWARE.                                                     *
+ *                                                               *
+ * Except as contained in this notice, the name of a copyright   *
+ * holder shall not be used in advertising or otherwise to       *
+ * promote the sale, use or other dealings in this Software      *
+ * without prior written authorization of the copyright holder.  *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "brown.h"
+#include "boards.h"
+#include "generate_move.h"
+
+/* Moves are 1D coordinates, with board_size * board_size for a pass,
+ * which is also the index of the pass output of the networks.
+ */
+
+static void *
+allocate(size_t size)
+{
+  void *p = malloc(size);
+  if (p == NULL) {
+    fprintf(stderr, "Out of memory for the boards\n");
+    exit(1);
+  }
+  return p;
+}
+
+/* Set up count games on empty boards. A game ends after two passes in
+ * a row or after max_moves moves, which is three times the number of
+ * points unless changed.
+ */
+void
+init_boards(boards_t *bs, int count, int board_size, float komi)
+{
+  int k;
+
+  bs->count = count;
+  bs->board_size = board_size;
+  bs->max_moves = 3 * board_size * board_size;
+  bs->boards = allocate(count * sizeof(board_t));
+  bs->to_move = allocate(count * sizeof(int));
+  bs->passes = allocate(count * sizeof(int));
+  bs->moves = allocate(count * sizeof(int));
+  bs->finished = allocate(count * sizeof(int));
+  bs->masks = allocate(count * MOVE_MASK_WORDS * sizeof(uint64_t));
+  bs->inputs = allocate(count * (board_size * board_size + 1) * sizeof(double));
+
+  for (k = 0; k < count; k++) {
+    init_brown(&bs->boards[k]);
+    bs->boards[k].komi = komi;
+    set_board_size(&bs->boards[k], board_size);
+  }
+  clear_boards(bs);
+}
+
+void
+free_boards(boards_t *bs)
+{
+  int k;
+
+  for (k = 0; k < bs->count; k++)
+    free_brown(&bs->boards[k]);
+  free(bs->boards);
+  free(bs->to_move);
+  free(bs->passes);
+  free(bs->moves);
+  free(bs->finished);
+  free(bs->masks);
+  free(bs->inputs);
+}
+
+/* Start all games again, black to move. */
+void
+clear_boards(boards_t *bs)
+{
+  int k;
+
+  for (k = 0; k < bs->count; k++) {
+    clear_board(&bs->boards[k]);
+    bs->to_move[k] = BLACK;
+    bs->passes[k] = 0;
+    bs->moves[k] = 0;
+    bs->finished[k] = 0;
+  }
+}
+
+/* Number of games which have ended. */
+int
+boards_finished(boards_t *bs)
+{
+  int finished = 0;
+  int k;
+
+  for (k = 0; k < bs->count; k++)
+    finished += bs->finished[k];
+  return finished;
+}
+
+/* Play one move in every game that has not ended, for the color to
+ * move. No legality check is done here, as in play_move().
+ */
+void
+play_moves(boards_t *bs, const int *moves)
+{
+  int points = bs->board_size * bs->board_size;
+  int k;
+
+  for (k = 0; k < bs->count; k++) {
+    board_t *b = &bs->boards[k];
+    if (bs->finished[k])
+      continue;
+    if (moves[k] == points) {
+      play_move(b, -1, -1, bs->to_move[k]);
+      bs->passes[k]++;
+    }
+    else {
+      play_move(b, I(b, moves[k]), J(b, moves[k]), bs->to_move[k]);
+      bs->passes[k] = 0;
+    }
+    bs->to_move[k] = OTHER_COLOR(bs->to_move[k]);
+    bs->moves[k]++;
+    bs->finished[k] = bs->passes[k] >= 2 || bs->moves[k] >= bs->max_moves;
+  }
+}
+
+/* Fill masks with the legal moves of every game. Ended games have no
+ * legal moves.
+ */
+void
+legal_move_masks(boards_t *bs)
+{
+  int k, w;
+
+  for (k = 0; k < bs->count; k++) {
+    uint64_t *mask = bs->masks + k * MOVE_MASK_WORDS;
+    if (bs->finished[k])
+      for (w = 0; w < MOVE_MASK_WORDS; w++)
+	mask[w] = 0;
+    else
+      legal_move_mask(&bs->boards[k], bs->to_move[k], mask);
+  }
+}
+
+/* Fill inputs with the network inputs of every game, so that all of
+ * them can be run as one batch.
+ */
+void
+boards_inputs(boards_t *bs)
+{
+  int size = bs->board_size * bs->board_size + 1;
+  int k;
+
+  for (k = 0; k < bs->count; k++)
+    generate_ann_inputs(&bs->boards[k], bs->to_move[k], bs->inputs + k * size);
+}
+
+/* The best legal move of every game for a batch of network outputs,
+ * which must follow legal_move_masks(). Ended games pass.
+ */
+void
+select_moves(boards_t *bs, const double *predictions, int *moves)
+{
+  int points = bs->board_size * bs->board_size;
+  int k;
+
+  for (k = 0; k < bs->count; k++)
+    moves[k] = best_move_index(points, bs->masks + k * MOVE_MASK_WORDS,
+			       predictions + k * (points + 1));
+}
@@ -0,0 +1,75 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * This is Evo, a simple go program.                             *
+ *                                                               *
+ * Copyright 2023 by Urban Hafner                                *
+ *           2003 and 2004 by Gunnar Farnebäck.                  *
+ *                                                               *
+ * Permission is hereby granted, free of charge, to any person   *
+ * obtaining a copy of this file gtp.c, to deal in the Software  *
+ * without restriction, including without limitation the rights  *
+ * to use, copy, modify, merge, publish, distribute, and/or      *
+ * sell copies of the Software, and to permit persons to whom    *
+ * the Software is furnished to do so, provided that the above   *
+ * copyright notice(s) and this permission notice appear in all  *
+ * copies of the Software and that both the above copyright      *
+ * notice(s) and this permission notice appear in supporting     *
+ * documentation.                                                *
+ *                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY     *
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE    *
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR       *
+ * PURPOSE AND NONINFRINGEMENT OF THIRD PARTY RIGHTS. IN NO      *
+ * EVENT SHALL THE COPYRIGHT HOLDER OR HOLDERS INCLUDED IN THIS  *
+ * NOTICE BE LIABLE FOR ANY CLAIM, OR ANY SPECIAL INDIRECT OR    *
+ * CONSEQUENTIAL DAMAGES, OR ANY DAMAGES WHATSOEVER RESULTING    *
+ * FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF    *
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT    *
+ * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS       *
+ * SOFTWARE.                                                     *
+ *                                                               *
+ * Except as contained in this notice, the name of a copyright   *
+ * holder shall not be used in advertising or otherwise to       *
+ * promote the sale, use or other dealings in this Software      *
+ * without prior written authorization of the copyright holder.  *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Several games on boards of the same size, advanced in lockstep by a
+ * single thread. Everything that is kept per game lives in arrays
+ * indexed by the game, so a batch of moves, legal move masks and
+ * network inputs lines up with a batch of network outputs. Each game
+ * has its own board_t, which keeps the strings and the history.
+ */
+typedef struct boards_t {
+  int count;
+  int board_size;
+  int max_moves;
+
+  board_t *boards;
+
+  /* Color to move, consecutive passes and moves played so far. */
+  int *to_move;
+  int *passes;
+  int *moves;
+
+  /* Set once a game ended with two passes or after max_moves. */
+  int *finished;
+
+  /* Legal moves of the color to move, MOVE_MASK_WORDS per game, see
+   * legal_move_mask().
+   */
+  uint64_t *masks;
+
+  /* Network inputs of the color to move, board_size * board_size + 1
+   * per game, see generate_ann_inputs().
+   */
+  double *inputs;
+} boards_t;
+
+void init_boards(boards_t *bs, int count, int board_size, float komi);
+void free_boards(boards_t *bs);
+void clear_boards(boards_t *bs);
+int boards_finished(boards_t *bs);
+void play_moves(boards_t *bs, const int *moves);
+void legal_move_masks(boards_t *bs);
+void boards_inputs(boards_t *bs);
+void select_moves(boards_t *bs, const double *predictions, int *moves);
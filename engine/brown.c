@@ -38,401 +38,305 @@
 #include <string.h>
 
 #include "brown.h"
-#include "generate_move.h"
 
-/* The GTP specification leaves the initial board size and komi to the
- * discretion of the engine. We make the uncommon choices of 6x6 board
- * and komi -3.14.
+/* Zobrist hash of the empty board. It is nonzero so that 0 can mark
+ * free slots in the position history.
  */
-int board_size = 6;
-float komi = -3.14;
+#define EMPTY_BOARD_HASH 0x9e3779b97f4a7c15ULL
 
-/* Board represented by a 1D array. The first board_size*board_size
- * elements are used. Vertices are indexed row by row, starting with 0
- * in the upper left corner.
+/* Up to this many vertices without an empty neighbour are checked one
+ * by one in legal_move_mask(), more are checked through the strings.
  */
-static int board[MAX_BOARD * MAX_BOARD];
-
-/* Stones are linked together in a circular list for each string. */
-static int next_stone[MAX_BOARD * MAX_BOARD];
-
-/* Storage for final status computations. */
-static int final_status[MAX_BOARD * MAX_BOARD];
-
-/* Point which would be an illegal ko recapture. */
-static int ko_i, ko_j;
-
+#define CROWDED_ONE_BY_ONE 16
 
-void init_brown() {
-  clear_board();
-}
-
-void clear_board() {
-  memset(board, 0, sizeof(board));
-}
 
-int
-board_empty()
+/* Zobrist key for a stone of color on bit, and with color EMPTY for
+ * white to move. The keys are a fixed function of their arguments
+ * (SplitMix64), so hashes are the same in every run and can be
+ * compared between programs.
+ */
+static uint64_t
+zobrist(int color, int bit)
 {
-  int i;
-  for (i = 0; i < board_size * board_size; i++)
-    if (board[i] != EMPTY)
-      return 0;
-
-  return 1;
+  uint64_t z = 0x45766f + ((uint64_t)color << 10 | (bit + 1))
+    * 0x9e3779b97f4a7c15ULL;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
 }
 
-int
-get_board(int i, int j)
-{
-  return board[i * board_size + j];
+/* The GTP specification leaves the initial board size and komi to the
+ * discretion of the engine. We make the uncommon choices of 6x6 board
+ * and komi -3.14.
+ */
+void init_brown(board_t *b) {
+  b->komi = -3.14;
+  b->history = NULL;
+  b->history_capacity = 0;
+  b->undo_stack = NULL;
+  b->undo_capacity = 0;
+  set_board_size(b, 6);
 }
 
-/* Get the stones of a string. stonei and stonej must point to arrays
- * sufficiently large to hold any string on the board. The number of
- * stones in the string is returned.
- */
-int
-get_string(int i, int j, int *stonei, int *stonej)
-{
-  int num_stones = 0;
-  int pos = POS(i, j);
-  do {
-    stonei[num_stones] = I(pos);
-    stonej[num_stones] = J(pos);
-    num_stones++;
-    pos = next_stone[pos];
-  } while (pos != POS(i, j));
-
-  return num_stones;
+/* Free the memory held by a board, but not the board itself. */
+void free_brown(board_t *b) {
+  free(b->history);
+  b->history = NULL;
+  b->history_capacity = 0;
+  free(b->undo_stack);
+  b->undo_stack = NULL;
+  b->undo_capacity = 0;
 }
 
+
 static int
-pass_move(int i, int j)
+history_contains(board_t *b, uint64_t hash)
 {
-  return i == -1 && j == -1;
-}
+  int mask = b->history_capacity - 1;
+  int k;
 
-int on_board(int i, int j) {
-  return i >= 0 && i < board_size && j >= 0 && j < board_size;
+  if (b->history_capacity == 0)
+    return 0;
+  for (k = hash & mask; b->history[k] != 0; k = (k + 1) & mask)
+    if (b->history[k] == hash)
+      return 1;
+  return 0;
 }
 
-int
-legal_move(int i, int j, int color)
+/* Add a hash to the history. Returns 1 if it was not there before. */
+static int
+history_add(board_t *b, uint64_t hash)
 {
-  int other = OTHER_COLOR(color);
-
-  /* Pass is always legal. */
-  if (pass_move(i, j))
-    return 1;
+  int mask;
+  int k;
 
-  /* Already occupied. */
-  if (get_board(i, j) != EMPTY)
+  if (history_contains(b, hash))
     return 0;
 
-  /* Illegal ko recapture. It is not illegal to fill the ko so we must
-   * check the color of at least one neighbor.
-   */
-  if (i == ko_i && j == ko_j
-      && ((on_board(i - 1, j) && get_board(i - 1, j) == other)
-	  || (on_board(i + 1, j) && get_board(i + 1, j) == other)))
-    return 0;
+  /* Keep the table at most half full. */
+  if (2 * (b->history_count + 1) > b->history_capacity) {
+    uint64_t *old = b->history;
+    int old_capacity = b->history_capacity;
+    b->history_capacity = old_capacity ? 2 * old_capacity : 1024;
+    b->history = calloc(b->history_capacity, sizeof(uint64_t));
+    if (b->history == NULL) {
+      fprintf(stderr, "Out of memory for the position history\n");
+      exit(1);
+    }
+    b->history_count = 0;
+    for (k = 0; k < old_capacity; k++)
+      if (old[k] != 0)
+	history_add(b, old[k]);
+    free(old);
+  }
 
+  mask = b->history_capacity - 1;
+  for (k = hash & mask; b->history[k] != 0; k = (k + 1) & mask)
+    ;
+  b->history[k] = hash;
+  b->history_count++;
   return 1;
 }
 
-/* Does the string at (i, j) have any more liberty than the one at
- * (libi, libj)?
+/* Remove a hash known to be in the history. The entries after it in
+ * the same probe sequence are moved back, so no deleted markers are
+ * needed.
  */
-static int
-has_additional_liberty(int i, int j, int libi, int libj)
+static void
+history_remove(board_t *b, uint64_t hash)
 {
-  int pos = POS(i, j);
-  do {
-    int ai = I(pos);
-    int aj = J(pos);
-    int k;
-    for (k = 0; k < 4; k++) {
-      int bi = ai + deltai[k];
-      int bj = aj + deltaj[k];
-      if (on_board(bi, bj) && get_board(bi, bj) == EMPTY
-	  && (bi != libi || bj != libj))
-      return 1;
+  int mask = b->history_capacity - 1;
+  int k, next;
+
+  for (k = hash & mask; b->history[k] != hash; k = (k + 1) & mask)
+    ;
+  for (next = (k + 1) & mask; b->history[next] != 0; next = (next + 1) & mask) {
+    int home = b->history[next] & mask;
+    /* The entry may fill the gap unless its home lies after the gap. */
+    if (((next - home) & mask) >= ((next - k) & mask)) {
+      b->history[k] = b->history[next];
+      k = next;
     }
+  }
+  b->history[k] = 0;
+  b->history_count--;
+}
 
-    pos = next_stone[pos];
-  } while (pos != POS(i, j));
+/* A new entry on top of the undo stack. */
+static undo_t *
+push_undo(board_t *b)
+{
+  if (b->undo_count == b->undo_capacity) {
+    b->undo_capacity = b->undo_capacity ? 2 * b->undo_capacity : 256;
+    b->undo_stack = realloc(b->undo_stack, b->undo_capacity * sizeof(undo_t));
+    if (b->undo_stack == NULL) {
+      fprintf(stderr, "Out of memory for the undo stack\n");
+      exit(1);
+    }
+  }
+  return &b->undo_stack[b->undo_count++];
+}
 
-  return 0;
+/* Zobrist hash of the position including the color to move. */
+uint64_t
+board_hash(board_t *b)
+{
+  return b->position_hash ^ (b->to_move == WHITE ? zobrist(EMPTY, 0) : 0);
 }
 
-/* Does (ai, aj) provide a liberty for a stone at (i, j)? */
 static int
-provides_liberty(int ai, int aj, int i, int j, int color)
+pass_move(int i, int j)
 {
-  /* A vertex off the board does not provide a liberty. */
-  if (!on_board(ai, aj))
-    return 0;
-
-  /* An empty vertex IS a liberty. */
-  if (get_board(ai, aj) == EMPTY)
-    return 1;
-
-  /* A friendly string provides a liberty to (i, j) if it currently
-   * has more liberties than the one at (i, j).
-   */
-  if (get_board(ai, aj) == color)
-    return has_additional_liberty(ai, aj, i, j);
-
-  /* An unfriendly string provides a liberty if and only if it is
-   * captured, i.e. if it currently only has the liberty at (i, j).
-   */
-  return !has_additional_liberty(ai, aj, i, j);
+  return i == -1 && j == -1;
 }
 
-int suicide(int i, int j, int color) {
-  int k;
-  for (k = 0; k < 4; k++)
-    if (provides_liberty(i + deltai[k], j + deltaj[k], i, j, color))
-      return 0;
-
-  return 1;
+int on_board(board_t *b, int i, int j) {
+  return i >= 0 && i < b->board_size && j >= 0 && j < b->board_size;
 }
 
-/* Remove a string from the board array. There is no need to modify
- * the next_stone array since this only matters where there are
- * stones present and the entire string is removed.
+/* The functions which depend on the board size, see brown_sized.h. */
+typedef struct board_ops {
+  void (*clear_board)(board_t *b);
+  int (*board_empty)(board_t *b);
+  int (*get_board)(board_t *b, int i, int j);
+  void (*board_inputs)(board_t *b, int color, double *inputs);
+  int (*get_string)(board_t *b, int i, int j, int *stonei, int *stonej);
+  int (*get_liberties)(board_t *b, int i, int j, int *libi, int *libj);
+  int (*legal_move)(board_t *b, int i, int j, int color);
+  void (*legal_move_mask)(board_t *b, int color, uint64_t *mask);
+  void (*play_move)(board_t *b, int i, int j, int color);
+  int (*unmake_move)(board_t *b);
+  void (*compute_final_status)(board_t *b);
+  int (*suicide)(board_t *b, int i, int j, int color);
+} board_ops;
+
+#define SIZE 9
+#include "brown_sized.h"
+#define SIZE 13
+#include "brown_sized.h"
+#define SIZE 19
+#include "brown_sized.h"
+#define SIZE 0
+#include "brown_sized.h"
+
+/* Change the board size, which clears the board. The sizes 9, 13 and
+ * 19 get code compiled for them, all others share the generic code.
  */
-static int
-remove_string(int i, int j)
+void set_board_size(board_t *b, int size) {
+  b->board_size = size;
+  switch (size) {
+  case 9:
+    b->ops = &ops_9;
+    break;
+  case 13:
+    b->ops = &ops_13;
+    break;
+  case 19:
+    b->ops = &ops_19;
+    break;
+  default:
+    b->ops = &ops_0;
+  }
+  clear_board(b);
+}
+
+void
+clear_board(board_t *b)
 {
-  int pos = POS(i, j);
-  int removed = 0;
-  do {
-    board[pos] = EMPTY;
-    removed++;
-    pos = next_stone[pos];
-  } while (pos != POS(i, j));
-
-  return removed;
+  b->ops->clear_board(b);
 }
 
-/* Do two vertices belong to the same string. It is required that both
- * pos1 and pos2 point to vertices with stones.
- */
-static int
-same_string(int pos1, int pos2)
+int
+board_empty(board_t *b)
 {
-  int pos = pos1;
-  do {
-    if (pos == pos2)
-      return 1;
-    pos = next_stone[pos];
-  } while (pos != pos1);
+  return b->ops->board_empty(b);
+}
 
-  return 0;
+int
+get_board(board_t *b, int i, int j)
+{
+  return b->ops->get_board(b, i, j);
 }
 
-/* Play at (i, j) for color. No legality check is done here. We need
- * to properly update the board array, the next_stone array, and the
- * ko point.
- */
-void play_move(int i, int j, int color)
+void
+board_inputs(board_t *b, int color, double *inputs)
 {
-  int pos = POS(i, j);
-  int captured_stones = 0;
-  int k;
+  b->ops->board_inputs(b, color, inputs);
+}
 
-  /* Reset the ko point. */
-  ko_i = -1;
-  ko_j = -1;
-
-  /* Nothing more happens if the move was a pass. */
-  if (pass_move(i, j))
-    return;
-
-  /* If the move is a suicide we only need to remove the adjacent
-   * friendly stones.
-   */
-  if (suicide(i, j, color)) {
-    for (k = 0; k < 4; k++) {
-      int ai = i + deltai[k];
-      int aj = j + deltaj[k];
-      if (on_board(ai, aj)
-	  && get_board(ai, aj) == color)
-	remove_string(ai, aj);
-    }
-    return;
-  }
+int
+get_string(board_t *b, int i, int j, int *stonei, int *stonej)
+{
+  return b->ops->get_string(b, i, j, stonei, stonej);
+}
 
-  /* Not suicide. Remove captured opponent strings. */
-  for (k = 0; k < 4; k++) {
-    int ai = i + deltai[k];
-    int aj = j + deltaj[k];
-    if (on_board(ai, aj)
-	&& get_board(ai, aj) == OTHER_COLOR(color)
-	&& !has_additional_liberty(ai, aj, i, j))
-      captured_stones += remove_string(ai, aj);
-  }
+int
+get_liberties(board_t *b, int i, int j, int *libi, int *libj)
+{
+  return b->ops->get_liberties(b, i, j, libi, libj);
+}
 
-  /* Put down the new stone. Initially build a single stone string by
-   * setting next_stone[pos] pointing to itself.
-   */
-  board[pos] = color;
-  next_stone[pos] = pos;
-
-  /* If we have friendly neighbor strings we need to link the strings
-   * together.
-   */
-  for (k = 0; k < 4; k++) {
-    int ai = i + deltai[k];
-    int aj = j + deltaj[k];
-    int pos2 = POS(ai, aj);
-    /* Make sure that the stones are not already linked together. This
-     * may happen if the same string neighbors the new stone in more
-     * than one direction.
-     */
-    if (on_board(ai, aj) && board[pos2] == color && !same_string(pos, pos2)) {
-      /* The strings are linked together simply by swapping the the
-       * next_stone pointers.
-       */
-      int tmp = next_stone[pos2];
-      next_stone[pos2] = next_stone[pos];
-      next_stone[pos] = tmp;
-    }
-  }
+int
+legal_move(board_t *b, int i, int j, int color)
+{
+  return b->ops->legal_move(b, i, j, color);
+}
 
-  /* If we have captured exactly one stone and the new string is a
-   * single stone it may have been a ko capture.
-   */
-  if (captured_stones == 1 && next_stone[pos] == pos) {
-    int ai, aj;
-    /* Check whether the new string has exactly one liberty. If so it
-     * would be an illegal ko capture to play there immediately. We
-     * know that there must be a liberty immediately adjacent to the
-     * new stone since we captured one stone.
-     */
-    for (k = 0; k < 4; k++) {
-      ai = i + deltai[k];
-      aj = j + deltaj[k];
-      if (on_board(ai, aj) && get_board(ai, aj) == EMPTY)
-	break;
-    }
+void
+legal_move_mask(board_t *b, int color, uint64_t *mask)
+{
+  b->ops->legal_move_mask(b, color, mask);
+}
 
-    if (!has_additional_liberty(i, j, ai, aj)) {
-      ko_i = ai;
-      ko_j = aj;
-    }
-  }
+void
+play_move(board_t *b, int i, int j, int color)
+{
+  b->ops->play_move(b, i, j, color);
 }
 
-/* Set a final status value for an entire string. */
-static void
-set_final_status_string(int pos, int status)
+int
+unmake_move(board_t *b)
 {
-  int pos2 = pos;
-  do {
-    final_status[pos2] = status;
-    pos2 = next_stone[pos2];
-  } while (pos2 != pos);
+  return b->ops->unmake_move(b);
 }
 
-/* Compute final status. This function is only valid to call in a
- * position where generate_move() would return pass for at least one
- * color.
- *
- * Due to the nature of the move generation algorithm, the final
- * status of stones can be determined by a very simple algorithm:
- *
- * 1. Stones with two or more liberties are alive with territory.
- * 2. Stones in atari are dead.
- *
- * Moreover alive stones are unconditionally alive even if the
- * opponent is allowed an arbitrary number of consecutive moves.
- * Similarly dead stones cannot be brought alive even by an arbitrary
- * number of consecutive moves.
- *
- * Seki is not an option. The move generation algorithm would never
- * leave a seki on the board.
- *
- * Comment: This algorithm doesn't work properly if the game ends with
- *          an unfilled ko. If three passes are required for game end,
- *          that will not happen.
- */
 void
-compute_final_status(void)
+compute_final_status(board_t *b)
 {
-  int i, j;
-  int pos;
-  int k;
+  b->ops->compute_final_status(b);
+}
 
-  for (pos = 0; pos < board_size * board_size; pos++)
-    final_status[pos] = UNKNOWN;
-
-  for (i = 0; i < board_size; i++)
-    for (j = 0; j < board_size; j++)
-      if (get_board(i, j) == EMPTY)
-	for (k = 0; k < 4; k++) {
-	  int ai = i + deltai[k];
-	  int aj = j + deltaj[k];
-	  if (!on_board(ai, aj))
-	    continue;
-	  /* When the game is finished, we know for sure that (ai, aj)
-           * contains a stone. The move generation algorithm would
-           * never leave two adjacent empty vertices. Check the number
-           * of liberties to decide its status, unless it's known
-           * already.
-	   *
-	   * If we should be called in a non-final position, just make
-	   * sure we don't call set_final_status_string() on an empty
-	   * vertex.
-	   */
-	  pos = POS(ai, aj);
-	  if (final_status[pos] == UNKNOWN) {
-	    if (get_board(ai, aj) != EMPTY) {
-	      if (has_additional_liberty(ai, aj, i, j))
-		set_final_status_string(pos, ALIVE);
-	      else
-		set_final_status_string(pos, DEAD);
-	    }
-	  }
-	  /* Set the final status of the (i, j) vertex to either black
-           * or white territory.
-	   */
-	  if (final_status[POS(i, j)] == UNKNOWN) {
-	    if ((final_status[pos] == ALIVE) ^ (get_board(ai, aj) == WHITE))
-	      final_status[POS(i, j)] = BLACK_TERRITORY;
-	    else
-	      final_status[POS(i, j)] = WHITE_TERRITORY;
-	  }
-	}
+int
+suicide(board_t *b, int i, int j, int color)
+{
+  return b->ops->suicide(b, i, j, color);
 }
 
 int
-get_final_status(int i, int j)
+get_final_status(board_t *b, int i, int j)
 {
-  return final_status[POS(i, j)];
+  return b->final_status[POS(b, i, j)];
 }
 
 void
-set_final_status(int i, int j, int status)
+set_final_status(board_t *b, int i, int j, int status)
 {
-  final_status[POS(i, j)] = status;
+  b->final_status[POS(b, i, j)] = status;
 }
 
 /* Valid number of stones for fixed placement handicaps. These are
  * compatible with the GTP fixed handicap placement rules.
  */
 int
-valid_fixed_handicap(int handicap)
+valid_fixed_handicap(board_t *b, int handicap)
 {
   if (handicap < 2 || handicap > 9)
     return 0;
-  if (board_size % 2 == 0 && handicap > 4)
+  if (b->board_size % 2 == 0 && handicap > 4)
     return 0;
-  if (board_size == 7 && handicap > 4)
+  if (b->board_size == 7 && handicap > 4)
     return 0;
-  if (board_size < 7 && handicap > 0)
+  if (b->board_size < 7 && handicap > 0)
     return 0;
 
   return 1;
@@ -442,48 +346,33 @@ valid_fixed_handicap(int handicap)
  * compatible with the GTP fixed handicap placement rules.
  */
 void
-place_fixed_handicap(int handicap)
+place_fixed_handicap(board_t *b, int handicap)
 {
-  int low = board_size >= 13 ? 3 : 2;
-  int mid = board_size / 2;
-  int high = board_size - 1 - low;
+  int low = b->board_size >= 13 ? 3 : 2;
+  int mid = b->board_size / 2;
+  int high = b->board_size - 1 - low;
 
   if (handicap >= 2) {
-    play_move(high, low, BLACK);   /* bottom left corner */
-    play_move(low, high, BLACK);   /* top right corner */
+    play_move(b, high, low, BLACK);   /* bottom left corner */
+    play_move(b, low, high, BLACK);   /* top right corner */
   }
 
   if (handicap >= 3)
-    play_move(low, low, BLACK);    /* top left corner */
+    play_move(b, low, low, BLACK);    /* top left corner */
 
   if (handicap >= 4)
-    play_move(high, high, BLACK);  /* bottom right corner */
+    play_move(b, high, high, BLACK);  /* bottom right corner */
 
   if (handicap >= 5 && handicap % 2 == 1)
-    play_move(mid, mid, BLACK);    /* tengen */
+    play_move(b, mid, mid, BLACK);    /* tengen */
 
   if (handicap >= 6) {
-    play_move(mid, low, BLACK);    /* left edge */
-    play_move(mid, high, BLACK);   /* right edge */
+    play_move(b, mid, low, BLACK);    /* left edge */
+    play_move(b, mid, high, BLACK);   /* right edge */
   }
 
   if (handicap >= 8) {
-    play_move(low, mid, BLACK);    /* top edge */
-    play_move(high, mid, BLACK);   /* bottom edge */
-  }
-}
-
-/* Put free placement handicap stones on the board. We do this simply
- * by generating successive black moves.
- */
-void
-place_free_handicap(int handicap)
-{
-  int k;
-  int i, j;
-
-  for (k = 0; k < handicap; k++) {
-    generate_move(&i, &j, BLACK);
-    play_move(i, j, BLACK);
+    play_move(b, low, mid, BLACK);    /* top edge */
+    play_move(b, high, mid, BLACK);   /* bottom edge */
   }
 }
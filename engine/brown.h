@@ -33,6 +33,8 @@
  * without prior written authorization of the copyright holder.  *
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
+#include <stdint.h>
+
 #define VERSION_STRING "1.0"
 
 #define MIN_BOARD 2
@@ -51,36 +53,156 @@
 #define BLACK_TERRITORY 4
 #define UNKNOWN 5
 
-/* Macros to convert between 1D and 2D coordinates. The 2D coordinate
- * (i, j) points to row i and column j, starting with (0,0) in the
- * upper left corner.
+#include "bitboard.h"
+
+/* Macros to convert between 1D and 2D coordinates of board b. The 2D
+ * coordinate (i, j) points to row i and column j, starting with (0,0)
+ * in the upper left corner. I and J look the coordinates up in tables
+ * of the board instead of dividing by the board size.
  */
-#define POS(i, j) ((i) * board_size + (j))
-#define I(pos) ((pos) / board_size)
-#define J(pos) ((pos) % board_size)
+#define POS(b, i, j) ((i) * (b)->board_size + (j))
+#define I(b, pos) ((b)->pos_i[pos])
+#define J(b, pos) ((b)->pos_j[pos])
+
+/* Words of a bitmask with one bit per vertex, see legal_move_mask(). */
+#define MOVE_MASK_WORDS ((MAX_BOARD * MAX_BOARD + 63) / 64)
 
 /* Macro to find the opposite color. */
 #define OTHER_COLOR(color) (WHITE + BLACK - (color))
 
-extern float komi;
-extern int board_size;
-
 /* Offsets for the four directly adjacent neighbors. Used for looping. */
 static int deltai[4] = {-1, 1, 0, 0};
 static int deltaj[4] = {0, 0, -1, 1};
 
-void init_brown(void);
-void clear_board(void);
-int board_empty(void);
-int get_board(int i, int j);
-int get_string(int i, int j, int *stonei, int *stonej);
-int legal_move(int i, int j, int color);
-void play_move(int i, int j, int color);
-void compute_final_status(void);
-int get_final_status(int i, int j);
-void set_final_status(int i, int j, int status);
-int valid_fixed_handicap(int handicap);
-void place_fixed_handicap(int handicap);
-void place_free_handicap(int handicap);
-int suicide(int i, int j, int color);
-int on_board(int i, int j);
+/* A string of stones together with its liberties. Both sets are kept
+ * up to date by play_move(), so liberty questions never have to walk
+ * the board.
+ */
+typedef struct go_string {
+  bitboard stones;
+  bitboard liberties;
+  uint64_t hash;
+} go_string;
+
+/* What play_move() changed, so that unmake_move() can take it back
+ * without looking at the rest of the board. The strings next to the
+ * move are saved as they were before it, which covers the strings it
+ * joined, the strings it captured and, for a suicide, the strings it
+ * removed.
+ */
+typedef struct undo_t {
+  /* The bit played, or -1 for a pass. */
+  int bit;
+  int color;
+  int was_suicide;
+
+  int ko_bit;
+  int to_move;
+  uint64_t position_hash;
+  bitboard removed_points;
+
+  /* Size of the stack of free ids and the id on top of it. */
+  int num_free_ids;
+  int free_top;
+
+  /* Whether the position after the move was new to the history. */
+  int new_position;
+
+  int num_saved;
+  int saved_ids[4];
+  int saved_colors[4];
+  go_string saved[4];
+} undo_t;
+
+/* A game in progress. All functions below take the board they work on,
+ * so a process can hold any number of games, one thread per board at a
+ * time. Set one up with init_brown() and release it with free_brown().
+ */
+typedef struct board_t {
+  int board_size;
+  float komi;
+
+  /* Code for this board size, chosen by set_board_size(). */
+  const struct board_ops *ops;
+
+  /* Layout of the bitboards, see bitboard.h. */
+  int stride;
+
+  /* The stones of each color, indexed by WHITE and BLACK. */
+  bitboard stones[3];
+
+  /* All points on the board. */
+  bitboard on_board_bits;
+
+  /* Bit of the bitboards to 1D coordinate, for reading off stones. */
+  int bit_to_pos[BB_WORDS * 64];
+
+  /* 1D coordinate to 2D coordinates, see I and J. */
+  int pos_i[MAX_BOARD * MAX_BOARD];
+  int pos_j[MAX_BOARD * MAX_BOARD];
+
+  /* Offsets of the four directly adjacent bits, in the same order as
+   * deltai and deltaj. Thanks to the sentinels they are the same for
+   * every point on the board.
+   */
+  int delta_bit[4];
+
+  /* Strings in use are found through string_id[] of any of their
+   * stones. Unused entries are kept on a stack of free ids.
+   */
+  go_string strings[MAX_BOARD * MAX_BOARD];
+  int string_id[BB_WORDS * 64];
+  int free_ids[MAX_BOARD * MAX_BOARD];
+  int num_free_ids;
+
+  /* Zobrist hash of the stones on the board, and the color to move. */
+  uint64_t position_hash;
+  int to_move;
+
+  /* Hashes of every position of the game so far, for positional
+   * superko. Open addressing with linear probing, history_capacity is
+   * a power of two and 0 marks a free slot.
+   */
+  uint64_t *history;
+  int history_count;
+  int history_capacity;
+
+  /* Points stones have been removed from during the game. A move that
+   * captures nothing can only repeat a position if it is played on one
+   * of them.
+   */
+  bitboard removed_points;
+
+  /* One entry for every move played since the board was cleared. */
+  undo_t *undo_stack;
+  int undo_count;
+  int undo_capacity;
+
+  /* Storage for final status computations. */
+  int final_status[MAX_BOARD * MAX_BOARD];
+
+  /* Bit of the point which would be an illegal ko recapture, or -1. */
+  int ko_bit;
+} board_t;
+
+void init_brown(board_t *b);
+void free_brown(board_t *b);
+void set_board_size(board_t *b, int size);
+void clear_board(board_t *b);
+int board_empty(board_t *b);
+uint64_t board_hash(board_t *b);
+int get_board(board_t *b, int i, int j);
+void board_inputs(board_t *b, int color, double *inputs);
+int get_string(board_t *b, int i, int j, int *stonei, int *stonej);
+int get_liberties(board_t *b, int i, int j, int *libi, int *libj);
+int legal_move(board_t *b, int i, int j, int color);
+void legal_move_mask(board_t *b, int color, uint64_t *mask);
+void play_move(board_t *b, int i, int j, int color);
+int unmake_move(board_t *b);
+void compute_final_status(board_t *b);
+int get_final_status(board_t *b, int i, int j);
+void set_final_status(board_t *b, int i, int j, int status);
+int valid_fixed_handicap(board_t *b, int handicap);
+void place_fixed_handicap(board_t *b, int handicap);
+int suicide(board_t *b, int i, int j, int color);
+int on_board(board_t *b, int i, int j);
@@ -0,0 +1,786 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * This is Evo, a simple go program.                             *
+ *                                                               *
+ * Copyright 2023 by Urban Hafner                                *
+ *           2003 and 2004 by Gunnar Farnebäck.                  *
+ *                                                               *
+ * Permission is hereby granted, free of charge, to any person   *
+ * obtaining a copy of this file gtp.c, to deal in the Software  *
+ * without restriction, including without limitation the rights  *
+ * to use, copy, modify, merge, publish, distribute, and/or      *
+ * sell copies of the Software, and to permit persons to whom    *
+ * the Software is furnished to do so, provided that the above   *
+ * copyright notice(s) and this permission notice appear in all  *
+ * copies of the Software and that both the above copyright      *
+ * notice(s) and this permission notice appear in supporting     *
+ * documentation.                                                *
+ *                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY     *
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE    *
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR       *
+ * PURPOSE AND NONINFRINGEMENT OF THIRD PARTY RIGHTS. IN NO      *
+ * EVENT SHALL THE COPYRIGHT HOLDER OR HOLDERS INCLUDED IN THIS  *
+ * NOTICE BE LIABLE FOR ANY CLAIM, OR ANY SPECIAL INDIRECT OR    *
+ * CONSEQUENTIAL DAMAGES, OR ANY DAMAGES WHATSOEVER RESULTING    *
+ * FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF    *
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT    *
+ * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS       *
+ * SOFTWARE.                                                     *
+ *                                                               *
+ * Except as contained in this notice, the name of a copyright   *
+ * holder shall not be used in advertising or otherwise to       *
+ * promote the sale, use or other dealings in this Software      *
+ * without prior written authorization of the copyright holder.  *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* The board code for one board size. brown.c includes this file once
+ * for every board size with a specialization, with SIZE defined to that
+ * size, and once with SIZE 0 for all other sizes. With a fixed size the
+ * stride, the neighbour offsets and the number of bitboard words are
+ * constants, so the compiler can unroll and fold the loops over them.
+ *
+ * The functions are renamed with the size as suffix and collected in
+ * the board_ops table SIZED(ops), which set_board_size() picks from.
+ */
+
+#define SIZED_PASTE(name, size) name##_##size
+#define SIZED_EXPAND(name, size) SIZED_PASTE(name, size)
+#define SIZED(name) SIZED_EXPAND(name, SIZE)
+
+#if SIZE
+#define BOARD_SIZE(b) SIZE
+#define STRIDE(b) (SIZE + 1)
+#define DELTA_BIT(b, k) SIZED(delta_bit)[k]
+#undef BB_ACTIVE
+#define BB_ACTIVE (((SIZE + 2) * (SIZE + 1) + 63) / 64)
+
+static const int SIZED(delta_bit)[4] = {-(SIZE + 1), SIZE + 1, -1, 1};
+#else
+#define BOARD_SIZE(b) ((b)->board_size)
+#define STRIDE(b) ((b)->stride)
+#define DELTA_BIT(b, k) ((b)->delta_bit[k])
+#endif
+
+#define BIT(b, i, j) (((i) + 1) * STRIDE(b) + (j) + 1)
+
+#define clear_board SIZED(clear_board)
+#define board_empty SIZED(board_empty)
+#define get_board SIZED(get_board)
+#define board_inputs SIZED(board_inputs)
+#define get_string SIZED(get_string)
+#define get_liberties SIZED(get_liberties)
+#define legal_move SIZED(legal_move)
+#define legal_move_mask SIZED(legal_move_mask)
+#define play_move SIZED(play_move)
+#define unmake_move SIZED(unmake_move)
+#define compute_final_status SIZED(compute_final_status)
+#define suicide SIZED(suicide)
+#define empty_points SIZED(empty_points)
+#define string_of SIZED(string_of)
+#define liberty_count SIZED(liberty_count)
+#define hash_after_move SIZED(hash_after_move)
+#define legal_bit SIZED(legal_bit)
+#define has_additional_liberty SIZED(has_additional_liberty)
+#define provides_liberty SIZED(provides_liberty)
+#define suicide_bit SIZED(suicide_bit)
+#define crowded_moves SIZED(crowded_moves)
+#define remove_string SIZED(remove_string)
+
+static void
+clear_board(board_t *b)
+{
+  int i, j, k;
+
+  b->stride = b->board_size + 1;
+  b->delta_bit[0] = -b->stride;
+  b->delta_bit[1] = b->stride;
+  b->delta_bit[2] = -1;
+  b->delta_bit[3] = 1;
+
+  /* Clear all words, a board of another size may have used more. */
+  bb_clear_n(&b->on_board_bits, BB_WORDS);
+  for (i = 0; i < BOARD_SIZE(b); i++)
+    for (j = 0; j < BOARD_SIZE(b); j++) {
+      bb_set(&b->on_board_bits, BIT(b, i, j));
+      b->bit_to_pos[BIT(b, i, j)] = POS(b, i, j);
+      b->pos_i[POS(b, i, j)] = i;
+      b->pos_j[POS(b, i, j)] = j;
+    }
+
+  bb_clear_n(&b->stones[WHITE], BB_WORDS);
+  bb_clear_n(&b->stones[BLACK], BB_WORDS);
+  b->num_free_ids = 0;
+  for (k = MAX_BOARD * MAX_BOARD - 1; k >= 0; k--)
+    b->free_ids[b->num_free_ids++] = k;
+  b->ko_bit = -1;
+  b->undo_count = 0;
+
+  b->position_hash = EMPTY_BOARD_HASH;
+  b->to_move = BLACK;
+  if (b->history != NULL)
+    memset(b->history, 0, b->history_capacity * sizeof(uint64_t));
+  b->history_count = 0;
+  history_add(b, b->position_hash);
+  bb_clear_n(&b->removed_points, BB_WORDS);
+}
+
+static int
+board_empty(board_t *b)
+{
+  bitboard occupied;
+  bb_or(&occupied, &b->stones[WHITE], &b->stones[BLACK]);
+  return bb_is_empty(&occupied);
+}
+
+static int
+get_board(board_t *b, int i, int j)
+{
+  int bit = BIT(b, i, j);
+  if (bb_test(&b->stones[BLACK], bit))
+    return BLACK;
+  if (bb_test(&b->stones[WHITE], bit))
+    return WHITE;
+  return EMPTY;
+}
+
+/* All empty points of the board. */
+static void
+empty_points(board_t *b, bitboard *empty)
+{
+  bitboard occupied;
+  bb_or(&occupied, &b->stones[WHITE], &b->stones[BLACK]);
+  bb_andnot(empty, &b->on_board_bits, &occupied);
+}
+
+/* The string of the stone at bit. */
+static go_string *
+string_of(board_t *b, int bit)
+{
+  return &b->strings[b->string_id[bit]];
+}
+
+static int
+liberty_count(const go_string *s)
+{
+  return bb_count(&s->liberties);
+}
+
+/* Write the position as seen by color to inputs, one value per vertex
+ * in 1D coordinate order: 1 for own stones, -1 for the opponent's and
+ * 0 for empty vertices.
+ */
+static void
+board_inputs(board_t *b, int color, double *inputs)
+{
+  int bit;
+
+  memset(inputs, 0, BOARD_SIZE(b) * BOARD_SIZE(b) * sizeof(double));
+  BB_FOR_EACH(&b->stones[color], bit)
+    inputs[b->bit_to_pos[bit]] = 1.0;
+  BB_FOR_EACH(&b->stones[OTHER_COLOR(color)], bit)
+    inputs[b->bit_to_pos[bit]] = -1.0;
+}
+
+/* Get the stones of a string. stonei and stonej must point to arrays
+ * sufficiently large to hold any string on the board. The number of
+ * stones in the string is returned.
+ */
+static int
+get_string(board_t *b, int i, int j, int *stonei, int *stonej)
+{
+  int num_stones = 0;
+  int bit;
+
+  BB_FOR_EACH(&string_of(b, BIT(b, i, j))->stones, bit) {
+    stonei[num_stones] = I(b, b->bit_to_pos[bit]);
+    stonej[num_stones] = J(b, b->bit_to_pos[bit]);
+    num_stones++;
+  }
+
+  return num_stones;
+}
+
+static int
+get_liberties(board_t *b, int i, int j, int *libi, int *libj)
+{
+  int num_liberties = 0;
+  int bit;
+
+  BB_FOR_EACH(&string_of(b, BIT(b, i, j))->liberties, bit) {
+    libi[num_liberties] = I(b, b->bit_to_pos[bit]);
+    libj[num_liberties] = J(b, b->bit_to_pos[bit]);
+    num_liberties++;
+  }
+
+  return num_liberties;
+}
+
+static int has_additional_liberty(board_t *b, int bit, int lib);
+static int suicide_bit(board_t *b, int bit, int color);
+
+/* Hash of the stones after color plays at the empty point bit. */
+static uint64_t
+hash_after_move(board_t *b, int bit, int color)
+{
+  uint64_t hash = b->position_hash;
+  int ids[4];
+  int num_ids = 0;
+  int suicide_move = suicide_bit(b, bit, color);
+  int k, m;
+
+  /* A suicide removes the friendly strings next to the point, any
+   * other move adds the stone and removes the captured strings.
+   */
+  if (!suicide_move)
+    hash ^= zobrist(color, bit);
+  for (k = 0; k < 4; k++) {
+    int n = bit + DELTA_BIT(b, k);
+    int removed;
+    if (suicide_move)
+      removed = bb_test(&b->stones[color], n);
+    else
+      removed = bb_test(&b->stones[OTHER_COLOR(color)], n)
+		&& !has_additional_liberty(b, n, bit);
+    if (!removed)
+      continue;
+    for (m = 0; m < num_ids && ids[m] != b->string_id[n]; m++)
+      ;
+    if (m == num_ids) {
+      ids[num_ids++] = b->string_id[n];
+      hash ^= b->strings[b->string_id[n]].hash;
+    }
+  }
+
+  return hash;
+}
+
+static int
+legal_bit(board_t *b, int bit, int color)
+{
+  int other = OTHER_COLOR(color);
+
+  /* Already occupied. */
+  if (bb_test(&b->stones[WHITE], bit) || bb_test(&b->stones[BLACK], bit))
+    return 0;
+
+  /* Illegal ko recapture. It is not illegal to fill the ko so we must
+   * check the color of at least one neighbor.
+   */
+  if (bit == b->ko_bit
+      && (bb_test(&b->stones[other], bit - STRIDE(b))
+	  || bb_test(&b->stones[other], bit + STRIDE(b))))
+    return 0;
+
+  /* Positional superko, the move may not repeat an earlier position. */
+  if (history_contains(b, hash_after_move(b, bit, color)))
+    return 0;
+
+  return 1;
+}
+
+static int
+legal_move(board_t *b, int i, int j, int color)
+{
+  /* Pass is always legal. */
+  if (pass_move(i, j))
+    return 1;
+
+  return legal_bit(b, BIT(b, i, j), color);
+}
+
+/* Does the string at bit have any more liberty than the one at lib? */
+static int
+has_additional_liberty(board_t *b, int bit, int lib)
+{
+  const go_string *s = string_of(b, bit);
+  return liberty_count(s) > bb_test(&s->liberties, lib);
+}
+
+/* Does the neighbour at n provide a liberty for a stone of color at
+ * bit? An empty vertex does, a friendly string does if it has more
+ * liberties than the one at bit and an unfriendly string does if and
+ * only if it is captured. A sentinel does not.
+ */
+static int
+provides_liberty(board_t *b, int n, int bit, int color)
+{
+  if (bb_test(&b->stones[color], n))
+    return has_additional_liberty(b, n, bit);
+  if (bb_test(&b->stones[OTHER_COLOR(color)], n))
+    return !has_additional_liberty(b, n, bit);
+  return bb_test(&b->on_board_bits, n);
+}
+
+static int
+suicide_bit(board_t *b, int bit, int color)
+{
+  int k;
+
+  for (k = 0; k < 4; k++)
+    if (provides_liberty(b, bit + DELTA_BIT(b, k), bit, color))
+      return 0;
+
+  return 1;
+}
+
+static int
+suicide(board_t *b, int i, int j, int color)
+{
+  return suicide_bit(b, BIT(b, i, j), color);
+}
+
+/* Vertices without an empty neighbour are decided by the strings around
+ * them. Either color may play there if the vertex is next to one of its
+ * strings with another liberty, or if it is the last liberty of an
+ * opponent string. Adds the crowded vertices color may play to moves.
+ */
+static void
+crowded_moves(board_t *b, int color, const bitboard *crowded, bitboard *moves)
+{
+  int other = OTHER_COLOR(color);
+  bitboard remaining, t;
+  bitboard safe[3], atari_liberties[3];
+  bitboard own_ok, other_ok;
+  int bit;
+
+  bb_clear(&safe[WHITE]);
+  bb_clear(&safe[BLACK]);
+  bb_clear(&atari_liberties[WHITE]);
+  bb_clear(&atari_liberties[BLACK]);
+  bb_or(&remaining, &b->stones[WHITE], &b->stones[BLACK]);
+  while ((bit = bb_first(&remaining)) >= 0) {
+    go_string *s = string_of(b, bit);
+    int c = bb_test(&b->stones[BLACK], bit) ? BLACK : WHITE;
+    if (liberty_count(s) >= 2)
+      bb_or(&safe[c], &safe[c], &s->stones);
+    else
+      bb_or(&atari_liberties[c], &atari_liberties[c], &s->liberties);
+    bb_andnot(&remaining, &remaining, &s->stones);
+  }
+
+  bb_neighbours(&own_ok, &safe[color], STRIDE(b), crowded);
+  bb_or(&own_ok, &own_ok, &atari_liberties[other]);
+  bb_neighbours(&other_ok, &safe[other], STRIDE(b), crowded);
+  bb_or(&other_ok, &other_ok, &atari_liberties[color]);
+
+  /* An opponent suicide is fine if it captures, which is the case as
+   * soon as an opponent stone is next to it.
+   */
+  bb_neighbours(&t, &b->stones[other], STRIDE(b), crowded);
+  bb_or(&other_ok, &other_ok, &t);
+
+  bb_and(&t, &own_ok, &other_ok);
+  bb_and(&t, &t, crowded);
+  bb_or(moves, moves, &t);
+}
+
+/* All vertices where color may play as a move of its own: legal, not
+ * a suicide, and not a suicide for the opponent unless it captures.
+ * The set is written as a bitmask with bit POS(i, j) for vertex (i, j).
+ *
+ * An empty vertex next to another empty vertex is never a suicide for
+ * either color, which settles most of the board at once. The others
+ * are looked at one by one while there are few of them, and through
+ * the strings otherwise. The superko test is needed only on vertices
+ * stones have been removed from, since every other move adds a stone
+ * where there never was one.
+ */
+static void
+legal_move_mask(board_t *b, int color, uint64_t *mask)
+{
+  int other = OTHER_COLOR(color);
+  bitboard empty, moves, crowded, t;
+  int bit, i;
+
+  empty_points(b, &empty);
+  bb_neighbours(&moves, &empty, STRIDE(b), &empty);
+  bb_andnot(&crowded, &empty, &moves);
+
+  if (bb_count(&crowded) > CROWDED_ONE_BY_ONE)
+    crowded_moves(b, color, &crowded, &moves);
+  else
+    BB_FOR_EACH(&crowded, bit) {
+      int k;
+      if (suicide_bit(b, bit, color))
+	continue;
+      if (suicide_bit(b, bit, other)) {
+	/* Unless it's a capture move. */
+	for (k = 0; k < 4; k++)
+	  if (bb_test(&b->stones[other], bit + DELTA_BIT(b, k)))
+	    break;
+	if (k == 4)
+	  continue;
+      }
+      bb_set(&moves, bit);
+    }
+
+  if (b->ko_bit >= 0 && !legal_bit(b, b->ko_bit, color))
+    bb_reset(&moves, b->ko_bit);
+
+  bb_and(&t, &moves, &b->removed_points);
+  BB_FOR_EACH(&t, bit)
+    if (history_contains(b, hash_after_move(b, bit, color)))
+      bb_reset(&moves, bit);
+
+  /* Drop the padding bit at the end of every row. */
+  memset(mask, 0, MOVE_MASK_WORDS * sizeof(uint64_t));
+  for (i = 0; i < BOARD_SIZE(b); i++) {
+    int from = BIT(b, i, 0);
+    int to = POS(b, i, 0);
+    uint64_t row = moves.w[from >> 6] >> (from & 63);
+    if ((from & 63) + BOARD_SIZE(b) > 64)
+      row |= moves.w[(from >> 6) + 1] << (64 - (from & 63));
+    row &= ((uint64_t)1 << BOARD_SIZE(b)) - 1;
+    mask[to >> 6] |= row << (to & 63);
+    if ((to & 63) + BOARD_SIZE(b) > 64)
+      mask[(to >> 6) + 1] |= row >> (64 - (to & 63));
+  }
+}
+
+/* Remove a string from the board. The strings next to it gain its
+ * stones as liberties. Returns the number of stones removed.
+ */
+static int
+remove_string(board_t *b, int id, int color)
+{
+  go_string *s = &b->strings[id];
+  bitboard adjacent, t;
+  int removed = bb_count(&s->stones);
+  int bit;
+
+  bb_andnot(&b->stones[color], &b->stones[color], &s->stones);
+  bb_or(&b->removed_points, &b->removed_points, &s->stones);
+  b->position_hash ^= s->hash;
+  bb_neighbours(&adjacent, &s->stones, STRIDE(b), &b->stones[OTHER_COLOR(color)]);
+  while ((bit = bb_first(&adjacent)) >= 0) {
+    go_string *neighbour = string_of(b, bit);
+    bb_neighbours(&t, &neighbour->stones, STRIDE(b), &s->stones);
+    bb_or(&neighbour->liberties, &neighbour->liberties, &t);
+    bb_andnot(&adjacent, &adjacent, &neighbour->stones);
+  }
+
+  b->free_ids[b->num_free_ids++] = id;
+  return removed;
+}
+
+/* Play at (i, j) for color. No legality check is done here. We need
+ * to properly update the stones of both colors, the strings, the ko
+ * point and the hashes, and record the move on the undo stack.
+ */
+static void
+play_move(board_t *b, int i, int j, int color)
+{
+  int other = OTHER_COLOR(color);
+  int bit = BIT(b, i, j);
+  int captured_stones = 0;
+  int id = -1;
+  int neighbours[4];
+  bitboard point, empty, liberties;
+  undo_t *u = push_undo(b);
+  go_string *s;
+  int k, m, n;
+
+  u->bit = pass_move(i, j) ? -1 : bit;
+  u->color = color;
+  u->was_suicide = 0;
+  u->ko_bit = b->ko_bit;
+  u->to_move = b->to_move;
+  u->position_hash = b->position_hash;
+  u->removed_points = b->removed_points;
+  u->num_free_ids = b->num_free_ids;
+  u->free_top = b->free_ids[b->num_free_ids - 1];
+  u->new_position = 0;
+  u->num_saved = 0;
+
+  /* Reset the ko point. */
+  b->ko_bit = -1;
+
+  b->to_move = other;
+
+  /* Nothing more happens if the move was a pass. */
+  if (pass_move(i, j))
+    return;
+
+  for (k = 0; k < 4; k++) {
+    neighbours[k] = n = bit + DELTA_BIT(b, k);
+    if (!(bb_test(&b->stones[WHITE], n) || bb_test(&b->stones[BLACK], n)))
+      continue;
+    for (m = 0; m < u->num_saved && u->saved_ids[m] != b->string_id[n]; m++)
+      ;
+    if (m == u->num_saved) {
+      u->saved_ids[m] = b->string_id[n];
+      u->saved_colors[m] = bb_test(&b->stones[color], n) ? color : other;
+      u->saved[m] = *string_of(b, n);
+      u->num_saved++;
+    }
+  }
+
+  /* If the move is a suicide we only need to remove the adjacent
+   * friendly stones.
+   */
+  if (suicide_bit(b, bit, color)) {
+    for (k = 0; k < 4; k++) {
+      n = neighbours[k];
+      if (bb_test(&b->stones[color], n))
+	remove_string(b, b->string_id[n], color);
+    }
+    u->was_suicide = 1;
+    u->new_position = history_add(b, b->position_hash);
+    return;
+  }
+
+  /* Not suicide. The point is no longer a liberty of the opponent
+   * strings next to it, which captures those that had no other.
+   */
+  for (k = 0; k < 4; k++) {
+    n = neighbours[k];
+    if (bb_test(&b->stones[other], n)) {
+      s = string_of(b, n);
+      bb_reset(&s->liberties, bit);
+      if (bb_is_empty(&s->liberties))
+	captured_stones += remove_string(b, b->string_id[n], other);
+    }
+  }
+
+  /* Put down the new stone and join it with the friendly strings next
+   * to it. The biggest string is kept and the others are relabeled.
+   */
+  for (k = 0; k < 4; k++) {
+    n = neighbours[k];
+    if (bb_test(&b->stones[color], n)
+	&& (id < 0 || bb_count(&string_of(b, n)->stones)
+		      > bb_count(&b->strings[id].stones)))
+      id = b->string_id[n];
+  }
+  if (id < 0) {
+    id = b->free_ids[--b->num_free_ids];
+    bb_clear(&b->strings[id].stones);
+    bb_clear(&b->strings[id].liberties);
+    b->strings[id].hash = 0;
+  }
+  s = &b->strings[id];
+
+  for (k = 0; k < 4; k++) {
+    n = neighbours[k];
+    if (bb_test(&b->stones[color], n) && b->string_id[n] != id) {
+      int joined_id = b->string_id[n];
+      go_string *joined = &b->strings[joined_id];
+      int stone;
+      bb_or(&s->stones, &s->stones, &joined->stones);
+      bb_or(&s->liberties, &s->liberties, &joined->liberties);
+      s->hash ^= joined->hash;
+      BB_FOR_EACH(&joined->stones, stone)
+	b->string_id[stone] = id;
+      b->free_ids[b->num_free_ids++] = joined_id;
+    }
+  }
+
+  bb_set(&b->stones[color], bit);
+  bb_set(&s->stones, bit);
+  b->string_id[bit] = id;
+  s->hash ^= zobrist(color, bit);
+  b->position_hash ^= zobrist(color, bit);
+  u->new_position = history_add(b, b->position_hash);
+  bb_clear(&point);
+  bb_set(&point, bit);
+  empty_points(b, &empty);
+  bb_neighbours(&liberties, &point, STRIDE(b), &empty);
+  bb_or(&s->liberties, &s->liberties, &liberties);
+  bb_reset(&s->liberties, bit);
+
+  /* If we have captured exactly one stone and the new string is a
+   * single stone it may have been a ko capture. That is the case when
+   * the new stone has exactly one liberty, the point just captured.
+   */
+  if (captured_stones == 1 && bb_count(&s->stones) == 1
+      && liberty_count(s) == 1)
+    b->ko_bit = bb_first(&s->liberties);
+}
+
+/* Take back the last move played. Returns 0 if there is none.
+ *
+ * The saved strings are put back first, so that every stone is labeled
+ * with its string again. The strings which were removed by the move
+ * then go back on the board and the points are taken from the liberties
+ * of the strings next to them.
+ */
+static int
+unmake_move(board_t *b)
+{
+  undo_t *u;
+  bitboard adjacent;
+  int bit, k;
+
+  if (b->undo_count == 0)
+    return 0;
+  u = &b->undo_stack[--b->undo_count];
+
+  if (u->bit >= 0 && !u->was_suicide)
+    bb_reset(&b->stones[u->color], u->bit);
+
+  for (k = 0; k < u->num_saved; k++) {
+    int id = u->saved_ids[k];
+    b->strings[id] = u->saved[k];
+    BB_FOR_EACH(&b->strings[id].stones, bit)
+      b->string_id[bit] = id;
+  }
+
+  for (k = 0; k < u->num_saved; k++) {
+    go_string *s = &u->saved[k];
+    int color = u->saved_colors[k];
+    if (bb_test(&b->stones[color], bb_first(&s->stones)))
+      continue;
+    bb_or(&b->stones[color], &b->stones[color], &s->stones);
+    bb_neighbours(&adjacent, &s->stones, STRIDE(b), &b->stones[OTHER_COLOR(color)]);
+    while ((bit = bb_first(&adjacent)) >= 0) {
+      go_string *neighbour = string_of(b, bit);
+      bb_andnot(&neighbour->liberties, &neighbour->liberties, &s->stones);
+      bb_andnot(&adjacent, &adjacent, &neighbour->stones);
+    }
+  }
+
+  /* The move only wrote to the free stack above this mark, so going
+   * back to it returns the ids the move took and drops those it freed.
+   * The top id may have been taken by the move and overwritten by a
+   * later one, so it is put back as well.
+   */
+  b->num_free_ids = u->num_free_ids;
+  b->free_ids[b->num_free_ids - 1] = u->free_top;
+  b->removed_points = u->removed_points;
+  if (u->new_position)
+    history_remove(b, b->position_hash);
+  b->position_hash = u->position_hash;
+  b->to_move = u->to_move;
+  b->ko_bit = u->ko_bit;
+
+  return 1;
+}
+
+/* Compute final status. This function is only valid to call in a
+ * position where generate_move() would return pass for at least one
+ * color.
+ *
+ * Due to the nature of the move generation algorithm, the final
+ * status of stones can be determined by a very simple algorithm:
+ *
+ * 1. Stones with two or more liberties are alive with territory.
+ * 2. Stones in atari are dead.
+ *
+ * Moreover alive stones are unconditionally alive even if the
+ * opponent is allowed an arbitrary number of consecutive moves.
+ * Similarly dead stones cannot be brought alive even by an arbitrary
+ * number of consecutive moves.
+ *
+ * Seki is not an option. The move generation algorithm would never
+ * leave a seki on the board.
+ *
+ * Every empty vertex is territory of the color its first neighbour
+ * (above, below, left, right) counts for: alive stones for their own
+ * color, dead stones for the opponent. In a non-final position an
+ * empty first neighbour counts for white.
+ *
+ * Comment: This algorithm doesn't work properly if the game ends with
+ *          an unfilled ko. If three passes are required for game end,
+ *          that will not happen.
+ */
+static void
+compute_final_status(board_t *b)
+{
+  bitboard empty, remaining;
+  bitboard black_side, decided, black_territory;
+  bitboard exists, neighbour, t;
+  int pos, bit, k;
+
+  for (pos = 0; pos < BOARD_SIZE(b) * BOARD_SIZE(b); pos++)
+    b->final_status[pos] = UNKNOWN;
+
+  /* Strings with two or more liberties are alive, the others dead. */
+  empty_points(b, &empty);
+  bb_clear(&black_side);
+  bb_or(&remaining, &b->stones[WHITE], &b->stones[BLACK]);
+  while ((bit = bb_first(&remaining)) >= 0) {
+    go_string *s = string_of(b, bit);
+    int color = bb_test(&b->stones[BLACK], bit) ? BLACK : WHITE;
+    int status = liberty_count(s) >= 2 ? ALIVE : DEAD;
+    if ((status == ALIVE) ^ (color == WHITE))
+      bb_or(&black_side, &black_side, &s->stones);
+    BB_FOR_EACH(&s->stones, bit)
+      b->final_status[b->bit_to_pos[bit]] = status;
+    bb_andnot(&remaining, &remaining, &s->stones);
+  }
+
+  /* Decide the empty vertices one direction at a time, in the same
+   * order as deltai and deltaj.
+   */
+  bb_clear(&decided);
+  bb_clear(&black_territory);
+  for (k = 0; k < 4; k++) {
+    int shift = deltai[k] != 0 ? STRIDE(b) : 1;
+    if (deltai[k] + deltaj[k] < 0) {
+      bb_shift_up(&exists, &b->on_board_bits, shift);
+      bb_shift_up(&neighbour, &black_side, shift);
+    }
+    else {
+      bb_shift_down(&exists, &b->on_board_bits, shift);
+      bb_shift_down(&neighbour, &black_side, shift);
+    }
+    bb_and(&exists, &exists, &empty);
+    bb_andnot(&exists, &exists, &decided);
+    bb_and(&t, &exists, &neighbour);
+    bb_or(&black_territory, &black_territory, &t);
+    bb_or(&decided, &decided, &exists);
+  }
+
+  BB_FOR_EACH(&decided, bit)
+    b->final_status[b->bit_to_pos[bit]] = bb_test(&black_territory, bit)
+      ? BLACK_TERRITORY : WHITE_TERRITORY;
+}
+
+static const board_ops SIZED(ops) = {
+  clear_board,
+  board_empty,
+  get_board,
+  board_inputs,
+  get_string,
+  get_liberties,
+  legal_move,
+  legal_move_mask,
+  play_move,
+  unmake_move,
+  compute_final_status,
+  suicide,
+};
+
+#undef clear_board
+#undef board_empty
+#undef get_board
+#undef board_inputs
+#undef get_string
+#undef get_liberties
+#undef legal_move
+#undef legal_move_mask
+#undef play_move
+#undef unmake_move
+#undef compute_final_status
+#undef suicide
+#undef empty_points
+#undef string_of
+#undef liberty_count
+#undef hash_after_move
+#undef legal_bit
+#undef has_additional_liberty
+#undef provides_liberty
+#undef suicide_bit
+#undef crowded_moves
+#undef remove_string
+
+#undef BIT
+#undef DELTA_BIT
+#undef STRIDE
+#undef BOARD_SIZE
+#undef BB_ACTIVE
+#define BB_ACTIVE BB_WORDS
+#undef SIZED
+#undef SIZED_EXPAND
+#undef SIZED_PASTE
+#undef SIZE
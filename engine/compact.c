@@ -0,0 +1,452 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * This is Evo, a simple go program.                             *
+ *                                                               *
+ * Copyright 2023 by Urban Hafner                                *
+ *           2003 and 2004 by Gunnar Farnebäck.                  *
+ *                                                               *
+ * Permission is hereby granted, free of charge, to any person   *
+ * obtaining a copy of this file gtp.c, to deal in the Software  *
+ * without restriction, including without limitation the rights  *
+ * to use, copy, modify, merge, publish, distribute, and/or      *
+ * sell copies of the Software, and to permit persons to whom    *
+ * the Software is furnished to do so, provided that the above   *
+ * copyright notice(s) and this permission notice appear in all  *
+ * copies of the Software and that both the above copyright      *
+ * notice(s) and this permission notice appear in supporting     *
+ * documentation.                                                *
+ *                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY     *
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE    *
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR       *
+ * PURPOSE AND NONINFRINGEMENT OF THIRD PARTY RIGHTS. IN NO      *
+ * EVENT SHALL THE COPYRIGHT HOLDER OR HOLDERS INCLUDED IN THIS  *
+ * NOTICE BE LIABLE FOR ANY CLAIM, OR ANY SPECIAL INDIRECT OR    *
+ * CONSEQUENTIAL DAMAGES, OR ANY DAMAGES WHATSOEVER RESULTING    *
+ * FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF    *
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT    *
+ * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS       *
+ * SOFTWARE.                                                     *
+ *                                                               *
+ * Except as contained in this notice, the name of a copyright   *
+ * holder shall not be used in advertising or otherwise to       *
+ * promote the sale, use or other dealings in this Software      *
+ * without prior written authorization of the copyright holder.  *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "brown.h"
+#include "genann.h"
+#include "generate_move.h"
+
+/* Removes hidden neurons that do not change the behaviour of a net.
+ *
+ * The net is run over a corpus of positions, taken from SGF files or,
+ * without any, from self-play games with random openings. Every hidden
+ * neuron whose output never changes over the corpus only adds a
+ * constant to the next layer, so that constant is folded into the bias
+ * of the next layer and the neuron is dropped. Neurons whose outgoing
+ * weights are all zero are dropped as well.
+ */
+
+#define SELF_PLAY_GAMES 100
+#define RANDOM_OPENING_MOVES 4
+
+pcg32_random_t rng;
+
+/* The net being compacted, playing the self-play games on its own. */
+static genann *ann;
+static board_t game;
+static player_t player;
+
+/* Input vectors of all positions in the corpus. */
+static double *corpus = NULL;
+static int corpus_size = 0;
+static int corpus_capacity = 0;
+
+static void
+add_position(int color)
+{
+  generate_ann_inputs(&game, color, player.inputs);
+  if (corpus_size == corpus_capacity) {
+    corpus_capacity = corpus_capacity ? 2 * corpus_capacity : 1024;
+    corpus = realloc(corpus, sizeof(double) * corpus_capacity * ann->inputs);
+  }
+  memcpy(corpus + corpus_size * ann->inputs, player.inputs, sizeof(double) * ann->inputs);
+  corpus_size++;
+}
+
+/* Read an SGF coordinate. Empty values and "tt" are passes. */
+static int
+sgf_point(const char *value, int *i, int *j)
+{
+  if (value[0] == '\0' || (strcmp(value, "tt") == 0 && game.board_size <= 19)) {
+    *i = -1;
+    *j = -1;
+    return 1;
+  }
+  if (strlen(value) != 2)
+    return 0;
+  *j = value[0] - 'a';
+  *i = value[1] - 'a';
+  return on_board(&game, *i, *j);
+}
+
+/* Replay the main line of an SGF game, adding the position before
+ * every move to the corpus. Only the properties needed for that are
+ * understood, everything else is skipped.
+ */
+static int
+replay_sgf(char *name)
+{
+  FILE *fd = fopen(name, "r");
+  char ident[16];
+  char value[256];
+  int c, added = 0;
+
+  if (fd == NULL) {
+    perror(name);
+    return 0;
+  }
+
+  clear_board(&game);
+  while ((c = fgetc(fd)) != EOF) {
+    int n = 0;
+
+    /* Only the first variation is replayed. */
+    if (c == ')')
+      break;
+    if (c < 'A' || c > 'Z')
+      continue;
+
+    while (c >= 'A' && c <= 'Z') {
+      if (n < (int)sizeof(ident) - 1)
+        ident[n++] = c;
+      c = fgetc(fd);
+    }
+    ident[n] = '\0';
+
+    while (c == ' ' || c == '\n' || c == '\r' || c == '\t')
+      c = fgetc(fd);
+
+    while (c == '[') {
+      int i, j;
+
+      n = 0;
+      while ((c = fgetc(fd)) != EOF && c != ']') {
+        if (c == '\\')
+          c = fgetc(fd);
+        if (n < (int)sizeof(value) - 1)
+          value[n++] = c;
+      }
+      value[n] = '\0';
+
+      if (!strcmp(ident, "SZ") && atoi(value) != game.board_size) {
+        fprintf(stderr, "%s: board size %s does not match the net\n", name, value);
+        fclose(fd);
+        return 0;
+      } else if (!strcmp(ident, "KM")) {
+        game.komi = atof(value);
+      } else if (!strcmp(ident, "AB") || !strcmp(ident, "AW")) {
+        if (sgf_point(value, &i, &j) && i >= 0)
+          play_move(&game, i, j, ident[1] == 'B' ? BLACK : WHITE);
+      } else if (!strcmp(ident, "B") || !strcmp(ident, "W")) {
+        int color = ident[0] == 'B' ? BLACK : WHITE;
+        if (!sgf_point(value, &i, &j) || !legal_move(&game, i, j, color)) {
+          fprintf(stderr, "%s: illegal move %s[%s], skipping the rest\n", name, ident, value);
+          fclose(fd);
+          return added;
+        }
+        add_position(color);
+        added++;
+        play_move(&game, i, j, color);
+      }
+
+      do {
+        c = fgetc(fd);
+      } while (c == ' ' || c == '\n' || c == '\r' || c == '\t');
+    }
+    ungetc(c, fd);
+  }
+
+  fclose(fd);
+  return added;
+}
+
+/* Play a random legal move that is not a suicide. Returns 0 if there
+ * is none.
+ */
+static int
+play_random_move(int color)
+{
+  int candidates[MAX_BOARD * MAX_BOARD];
+  int n = 0;
+  int pos;
+
+  for (pos = 0; pos < game.board_size * game.board_size; pos++) {
+    int i = I(&game, pos);
+    int j = J(&game, pos);
+    if (legal_move(&game, i, j, color) && !suicide(&game, i, j, color))
+      candidates[n++] = pos;
+  }
+
+  if (n == 0)
+    return 0;
+
+  pos = candidates[pcg32_boundedrand(n)];
+  play_move(&game, I(&game, pos), J(&game, pos), color);
+  return 1;
+}
+
+static void
+self_play(int games)
+{
+  int g, move;
+
+  for (g = 0; g < games; g++) {
+    int color = BLACK;
+    int passes = 0;
+
+    clear_board(&game);
+    for (move = 0; move < RANDOM_OPENING_MOVES; move++) {
+      add_position(color);
+      if (!play_random_move(color))
+        break;
+      color = OTHER_COLOR(color);
+    }
+
+    for (move = 0; passes < 2 && move < 2 * game.board_size * game.board_size; move++) {
+      int i, j;
+      add_position(color);
+      generate_move(&game, &player, &i, &j, color);
+      play_move(&game, i, j, color);
+      passes = (i == -1) ? passes + 1 : 0;
+      color = OTHER_COLOR(color);
+    }
+  }
+}
+
+/* Index of the first neuron of hidden layer h in ann->output. */
+static int
+layer_start(genann const *net, int h)
+{
+  int k, start = net->inputs;
+  for (k = 0; k < h; k++)
+    start += net->hidden_sizes[k];
+  return start;
+}
+
+/* Index of the first weight of layer h, where h == hidden_layers is
+ * the output layer.
+ */
+static int
+weight_start(genann const *net, int h)
+{
+  int k, start = 0, previous = net->inputs;
+  for (k = 0; k < h; k++) {
+    start += (previous + 1) * net->hidden_sizes[k];
+    previous = net->hidden_sizes[k];
+  }
+  return start;
+}
+
+static int
+layer_size(genann const *net, int h)
+{
+  return h < net->hidden_layers ? net->hidden_sizes[h] : net->outputs;
+}
+
+static genann *
+compact(genann *net, double tolerance)
+{
+  const int hidden_neurons = net->total_neurons - net->inputs - net->outputs;
+  double *low = malloc(sizeof(double) * hidden_neurons);
+  double *high = malloc(sizeof(double) * hidden_neurons);
+  int *keep = malloc(sizeof(int) * hidden_neurons);
+  int sizes[net->hidden_layers + 1];
+  int h, j, k, m, p;
+
+  /* Profile the hidden neurons over the corpus. */
+  for (p = 0; p < corpus_size; p++) {
+    genann_run(net, corpus + p * net->inputs);
+    for (k = 0; k < hidden_neurons; k++) {
+      double v = net->output[net->inputs + k];
+      if (p == 0 || v < low[k])
+        low[k] = v;
+      if (p == 0 || v > high[k])
+        high[k] = v;
+    }
+  }
+
+  genann *folded = genann_copy(net);
+
+  for (h = 0; h < net->hidden_layers; h++) {
+    const int first = layer_start(net, h) - net->inputs;
+    double *next = folded->weight + weight_start(net, h + 1);
+    const int row = net->hidden_sizes[h] + 1;
+
+    sizes[h] = 0;
+    for (j = 0; j < net->hidden_sizes[h]; j++) {
+      int zero = 1;
+      for (m = 0; m < layer_size(net, h + 1); m++)
+        if (next[m * row + j + 1] != 0.0)
+          zero = 0;
+
+      keep[first + j] = !zero && high[first + j] - low[first + j] > tolerance;
+      sizes[h] += keep[first + j];
+    }
+
+    /* A layer cannot be empty. */
+    if (sizes[h] == 0) {
+      keep[first] = 1;
+      sizes[h] = 1;
+    }
+
+    /* Fold the constant output of every dropped neuron into the bias of
+     * the next layer. The bias weight is multiplied by -1.
+     */
+    for (j = 0; j < net->hidden_sizes[h]; j++)
+      if (!keep[first + j])
+        for (m = 0; m < layer_size(net, h + 1); m++)
+          next[m * row] -= next[m * row + j + 1] * 0.5 * (low[first + j] + high[first + j]);
+  }
+
+  genann *small = genann_init_layers(net->inputs, net->hidden_layers, sizes, net->outputs);
+  double *w = small->weight;
+
+  /* Copy the weights of the kept neurons, leaving out the inputs that
+   * came from dropped ones.
+   */
+  for (h = 0; h <= net->hidden_layers; h++) {
+    const int inputs = h ? net->hidden_sizes[h - 1] : net->inputs;
+    const int first_input = h ? layer_start(net, h - 1) - net->inputs : 0;
+    double const *src = folded->weight + weight_start(net, h);
+
+    for (j = 0; j < layer_size(net, h); j++) {
+      double const *row = src + j * (inputs + 1);
+      if (h < net->hidden_layers && !keep[layer_start(net, h) - net->inputs + j])
+        continue;
+      *w++ = row[0];
+      for (k = 0; k < inputs; k++)
+        if (h == 0 || keep[first_input + k])
+          *w++ = row[k + 1];
+    }
+  }
+
+  free(low);
+  free(high);
+  free(keep);
+  genann_free(folded);
+  return small;
+}
+
+/* Compare the compacted net with the original over the corpus. */
+static void
+verify(genann *net, genann *small)
+{
+  double max_error = 0;
+  int disagreements = 0;
+  int p, k;
+
+  for (p = 0; p < corpus_size; p++) {
+    double const *in = corpus + p * net->inputs;
+    double const *expected = genann_run(net, in);
+    double const *actual = genann_run(small, in);
+    int best_expected = 0, best_actual = 0;
+
+    for (k = 0; k < net->outputs; k++) {
+      max_error = fmax(max_error, fabs(expected[k] - actual[k]));
+      if (expected[k] > expected[best_expected])
+        best_expected = k;
+      if (actual[k] > actual[best_actual])
+        best_actual = k;
+    }
+    disagreements += best_expected != best_actual;
+  }
+
+  printf("Max output difference %.3e, different best output in %d of %d positions\n",
+	 max_error, disagreements, corpus_size);
+}
+
+static void
+usage(void)
+{
+  fprintf(stderr, "Usage: compact [-t tolerance] [-g self-play games] in.ann out.ann [game.sgf ...]\n");
+  exit(1);
+}
+
+int
+main(int argc, char **argv)
+{
+  double tolerance = 0;
+  int games = SELF_PLAY_GAMES;
+  int opt, k, size;
+
+  pcg32_srandom(time(NULL), (intptr_t)&rng);
+  setbuf(stdout, NULL);
+
+  while ((opt = getopt(argc, argv, "t:g:")) != -1) {
+    if (opt == 't')
+      tolerance = atof(optarg);
+    else if (opt == 'g')
+      games = atoi(optarg);
+    else
+      usage();
+  }
+  if (argc - optind < 2)
+    usage();
+
+  FILE *fd = fopen(argv[optind], "rb");
+  if (fd == NULL) {
+    perror(argv[optind]);
+    exit(1);
+  }
+  ann = genann_binary_read(fd);
+  fclose(fd);
+  if (ann == NULL)
+    exit(1);
+
+  size = (int)(sqrt(ann->inputs - 1) + 0.5);
+  if (size < MIN_BOARD || size > MAX_BOARD) {
+    fprintf(stderr, "%d inputs do not fit any board size\n", ann->inputs);
+    exit(1);
+  }
+  init_brown(&game);
+  set_board_size(&game, size);
+  init_player(&player, &ann, 1);
+
+  for (k = optind + 2; k < argc; k++)
+    replay_sgf(argv[k]);
+  if (optind + 2 == argc)
+    self_play(games);
+
+  if (corpus_size == 0) {
+    fprintf(stderr, "No positions to profile the net with\n");
+    exit(1);
+  }
+  printf("Profiling %s over %d positions\n", argv[optind], corpus_size);
+
+  genann *small = compact(ann, tolerance);
+
+  printf("Neurons per layer:");
+  for (k = 0; k < ann->hidden_layers; k++)
+    printf(" %d -> %d", ann->hidden_sizes[k], small->hidden_sizes[k]);
+  printf("\nWeights: %d -> %d\n", ann->total_weights, small->total_weights);
+  verify(ann, small);
+
+  fd = fopen(argv[optind + 1], "wb");
+  if (fd == NULL) {
+    perror(argv[optind + 1]);
+    exit(1);
+  }
+  genann_binary_write(small, fd);
+  fclose(fd);
+
+  genann_free(small);
+  return 0;
+}
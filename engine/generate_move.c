@@ -33,67 +33,84 @@
  * without prior written authorization of the copyright holder.  *
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
+#include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 
 #include "brown.h"
 #include "genann.h"
-#include "interface.h"
+#include "generate_move.h"
+#include "population.h"
 
-// Build input for the neural network. Use 1 for stone of own color, -1 for other color
-void generate_ann_inputs(int color) {
-  int ai, aj;
-  int input_index = 1;
+// Set up a player for the given nets, which stay owned by the caller. All
+// weights are 1, the outputs are averaged and the nets run on one thread.
+void init_player(player_t *p, genann **anns, int count) {
+  int k;
+
+  p->anns = anns;
+  p->ann_count = count;
+  p->combine = COMBINE_MEAN;
+  p->threads = 1;
+  p->weights = malloc(count * sizeof(double));
+  for (k = 0; k < count; k++) p->weights[k] = 1.0;
+  p->inputs = malloc(anns[0]->inputs * sizeof(double));
+  p->predictions = malloc(count * anns[0]->outputs * sizeof(double));
+  p->combined = malloc(anns[0]->outputs * sizeof(double));
+}
+
+void free_player(player_t *p) {
+  free(p->weights);
+  free(p->inputs);
+  free(p->predictions);
+  free(p->combined);
+}
 
+// Build input for the neural network. Use 1 for stone of own color, -1 for other color
+void generate_ann_inputs(board_t *b, int color, double *inputs) {
   // Set komi as the first input
-  ann_inputs[0] = komi * (color == WHITE ? 1.0 : -1.0);
+  inputs[0] = b->komi * (color == WHITE ? 1.0 : -1.0);
   // Set all stones as inputs
-  for (ai = 0; ai < board_size; ai++)
-    for (aj = 0; aj < board_size; aj++) {
-      int v = get_board(ai, aj);
-      if (v == EMPTY) {
-        ann_inputs[input_index] = 0.0;
-      } else {
-        if (v == color) {
-          ann_inputs[input_index] = 1.0;
-        } else {
-          ann_inputs[input_index] = -1.0;
-        }
-      }
-      input_index++;
-    }
+  board_inputs(b, color, inputs + 1);
 }
 
-void find_and_set_best_move(int *i, int *j, int color, const double *prediction) {
-  int pred_index, ai, aj, k;
+// Index of the best output among the points in mask, or points for a pass
+int best_move_index(int points, const uint64_t *mask, const double *prediction) {
   int best_index = -1;
-  for(pred_index = 0; pred_index < ann->outputs - 1; pred_index++) {
-    if ((best_index == -1) || (prediction[pred_index] > prediction[best_index])) {
-      ai = I(pred_index);
-      aj = J(pred_index);
-      // Needs to be a legal move and not a suicide
-      if (legal_move(ai, aj, color) && !suicide(ai, aj, color)) {
-        // Can't be a suicide for the oppponent either
-        if (!suicide(ai, aj, OTHER_COLOR(color))) {
+  int legal = 0;
+  int k;
+
+  // Masked argmax, ties go to the first point as before. With few legal
+  // points walk their bits, otherwise scan all outputs.
+  for (k = 0; k < MOVE_MASK_WORDS; k++) legal += __builtin_popcountll(mask[k]);
+  if (4 * legal < points) {
+    for (k = 0; k < MOVE_MASK_WORDS; k++)
+      for (uint64_t bits = mask[k]; bits; bits &= bits - 1) {
+        int pred_index = k * 64 + __builtin_ctzll(bits);
+        if (best_index == -1 || prediction[pred_index] > prediction[best_index])
           best_index = pred_index;
-        } else {
-          // Unless it's a capture move
-          for (k = 0; k < 4; k++) {
-	          int bi = ai + deltai[k];
-	          int bj = aj + deltaj[k];
-	          if (on_board(bi, bj) && get_board(bi, bj) == OTHER_COLOR(color)) {
-              best_index = pred_index;
-              break;
-            }
-          }
-        }
       }
-    }
+  } else {
+    for (k = 0; k < points; k++)
+      if ((best_index == -1 || prediction[k] > prediction[best_index])
+          && (mask[k >> 6] >> (k & 63)) & 1)
+        best_index = k;
   }
   // Check the pass output, which is the last one
-  if ((best_index != -1) && (prediction[best_index] > prediction[ann->outputs - 1])) {
-    *i = I(best_index);
-    *j = J(best_index);
+  if ((best_index != -1) && (prediction[best_index] > prediction[points])) return best_index;
+  return points;
+}
+
+void find_and_set_best_move(board_t *b, int *i, int *j, int color, const double *prediction) {
+  uint64_t mask[MOVE_MASK_WORDS];
+  int points = b->board_size * b->board_size;
+  int best_index;
+
+  // Legal moves that are no suicide for either color, unless they capture
+  legal_move_mask(b, color, mask);
+  best_index = best_move_index(points, mask, prediction);
+  if (best_index < points) {
+    *i = I(b, best_index);
+    *j = J(b, best_index);
   } else {
     // Pass
     *i = -1;
@@ -101,23 +118,84 @@ void find_and_set_best_move(int *i, int *j, int color, const double *prediction)
   }
 }
 
-void check_ann_size() {
-  int points = board_size * board_size;
+void check_ann_size(board_t *b, player_t *p) {
+  int points = b->board_size * b->board_size;
   // Komi as input
   int input_size = points + 1;
   // Allow pass move as output
   int output_size = points + 1;
+  int k;
+
+  for (k = 0; k < p->ann_count; k++) {
+    genann *net = p->anns[k];
+    if (net->inputs != input_size || net->outputs != output_size) {
+      if(net->inputs != input_size) printf("Expected %d inputs. Got %d instead!\n", input_size, net->inputs);
+      if(net->outputs != output_size) printf("Expected %d outputs. Got %d instead!\n", output_size, net->outputs);
+      exit(1);
+    }
+  }
+}
+
+// Run all nets of the player on its inputs and combine their outputs. The
+// nets are only read, so players on other threads may share them.
+const double *player_prediction(board_t *b, player_t *p, int color) {
+  int outputs = p->anns[0]->outputs;
+  double total = 0, smallest = p->weights[0];
+  int k, n;
+
+  if (p->ann_count == 1) {
+    genann_run_batch(p->anns[0], 1, p->inputs, p->combined);
+    return p->combined;
+  }
+
+  memset(p->combined, 0, outputs * sizeof(double));
+  genann_run_population((genann const *const *)p->anns, p->ann_count, p->inputs, p->predictions, p->threads);
+
+  for (k = 0; k < p->ann_count; k++) {
+    const double *prediction = p->predictions + k * outputs;
+    double weight = p->combine == COMBINE_MEAN ? 1.0 : p->weights[k];
+    total += weight;
+    if (weight < smallest) smallest = weight;
+
+    if (p->combine == COMBINE_VOTE) {
+      // Each net votes for the move it would play on its own
+      int ai, aj;
+      find_and_set_best_move(b, &ai, &aj, color, prediction);
+      p->combined[ai == -1 ? outputs - 1 : POS(b, ai, aj)] += weight;
+    } else {
+      for (n = 0; n < outputs; n++) p->combined[n] += weight * prediction[n];
+    }
+  }
 
-  if (ann->inputs != input_size || ann->outputs != output_size) {
-    if(ann->inputs != input_size) printf("Expected %d inputs. Got %d instead!\n", input_size, ann->inputs);
-    if(ann->outputs != output_size) printf("Expected %d outputs. Got %d instead!\n", output_size, ann->outputs);
-    exit(1);
+  if (p->combine == COMBINE_VOTE) {
+    // Break ties by the mean output. Adds less than half the smallest vote.
+    for (k = 0; k < p->ann_count; k++)
+      for (n = 0; n < outputs; n++)
+        p->combined[n] += p->predictions[k * outputs + n] * smallest / (2.0 * p->ann_count);
+  } else {
+    for (n = 0; n < outputs; n++) p->combined[n] /= total;
   }
+
+  return p->combined;
 }
 
-void generate_move(int *i, int *j, int color) {
-  check_ann_size();
-  generate_ann_inputs(color);
-  double const *prediction = genann_run(ann, ann_inputs);
-  find_and_set_best_move(i, j, color, prediction);
+void generate_move(board_t *b, player_t *p, int *i, int *j, int color) {
+  check_ann_size(b, p);
+  generate_ann_inputs(b, color, p->inputs);
+  find_and_set_best_move(b, i, j, color, player_prediction(b, p, color));
+}
+
+/* Put free placement handicap stones on the board. We do this simply
+ * by generating successive black moves.
+ */
+void
+place_free_handicap(board_t *b, player_t *p, int handicap)
+{
+  int k;
+  int i, j;
+
+  for (k = 0; k < handicap; k++) {
+    generate_move(b, p, &i, &j, BLACK);
+    play_move(b, i, j, BLACK);
+  }
 }
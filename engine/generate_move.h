@@ -33,4 +33,34 @@
  * without prior written authorization of the copyright holder.  *
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
-void generate_move(int *i, int *j, int color);
+#include "genann.h"
+
+/* How the outputs of several nets are combined into one move. */
+#define COMBINE_MEAN 0
+#define COMBINE_VOTE 1
+#define COMBINE_WEIGHTED 2
+
+/* Who picks the moves: one net, or several playing as a committee, with
+ * the buffers to evaluate positions. The nets are only read, so players
+ * on different threads may share them, but each thread needs a player
+ * of its own.
+ */
+typedef struct player_t {
+  genann **anns;
+  int ann_count;
+  double *weights;
+  int combine;
+  int threads;
+  double *inputs;
+  double *predictions;
+  double *combined;
+} player_t;
+
+void init_player(player_t *p, genann **anns, int count);
+void free_player(player_t *p);
+void generate_ann_inputs(board_t *b, int color, double *inputs);
+int best_move_index(int points, const uint64_t *mask, const double *prediction);
+void find_and_set_best_move(board_t *b, int *i, int *j, int color, const double *prediction);
+const double *player_prediction(board_t *b, player_t *p, int color);
+void generate_move(board_t *b, player_t *p, int *i, int *j, int color);
+void place_free_handicap(board_t *b, player_t *p, int handicap);
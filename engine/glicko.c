@@ -0,0 +1 @@
+../lib/glicko.c
\ No newline at end of file
@@ -0,0 +1 @@
+../lib/glicko.h
\ No newline at end of file
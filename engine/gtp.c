@@ -135,6 +135,9 @@ gtp_main_loop(struct gtp_command commands[], FILE *gtp_input,
 
     if (status == GTP_FATAL)
       gtp_panic();
+
+    /* Send the whole response at once. */
+    fflush(stdout);
   }
 }
 
@@ -39,8 +39,10 @@
 #include <stdarg.h>
 #include <stdio.h>
 
-/* Maximum allowed line length in GTP. */
-#define GTP_BUFSIZE 1000
+/* Maximum allowed line length in GTP. It is generous so that
+ * evo-genmove_batch can ask for moves on many boards in one line.
+ */
+#define GTP_BUFSIZE 16384
 
 /* Status returned from callback functions. */
 #define GTP_QUIT    -1
@@ -0,0 +1,706 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * This is Evo, a simple go program.                             *
+ *                                                               *
+ * Copyright 2023 by Urban Hafner                                *
+ *           2003 and 2004 by Gunnar Farnebäck.                  *
+ *                                                               *
+ * Permission is hereby granted, free of charge, to any person   *
+ * obtaining a copy of this file gtp.c, to deal in the Software  *
+ * without restriction, including without limitation the rights  *
+ * to use, copy, modify, merge, publish, distribute, and/or      *
+ * sell copies of the Software, and to permit persons to whom    *
+ * the Software is furnished to do so, provided that the above   *
+ * copyright notice(s) and this permission notice appear in all  *
+ * copies of the Software and that both the above copyright      *
+ * notice(s) and this permission notice appear in supporting     *
+ * documentation.                                                *
+ *                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY     *
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE    *
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR       *
+ * PURPOSE AND NONINFRINGEMENT OF THIRD PARTY RIGHTS. IN NO      *
+ * EVENT SHALL THE COPYRIGHT HOLDER OR HOLDERS INCLUDED IN THIS  *
+ * NOTICE BE LIABLE FOR ANY CLAIM, OR ANY SPECIAL INDIRECT OR    *
+ * CONSEQUENTIAL DAMAGES, OR ANY DAMAGES WHATSOEVER RESULTING    *
+ * FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF    *
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT    *
+ * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS       *
+ * SOFTWARE.                                                     *
+ *                                                               *
+ * Except as contained in this notice, the name of a copyright   *
+ * holder shall not be used in advertising or otherwise to       *
+ * promote the sale, use or other dealings in this Software      *
+ * without prior written authorization of the copyright holder.  *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <fcntl.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "brown.h"
+#include "generate_move.h"
+#include "gtp.h"
+
+/* A GTP proxy in front of a deterministic engine, such as GnuGo with a
+ * fixed seed, which answers genmove from a cache on disk whenever the
+ * engine has been asked the same before:
+ *
+ *   gtpcache [--cache file] [--entries n] engine args ...
+ *   gtpcache --stats file
+ *
+ * Answers are keyed by the engine command, the board size, komi, the
+ * moves since clear_board and the color to move. The cache is an open
+ * addressing hash table in a file mapped into memory, which any number
+ * of proxies share. Lookups take no lock, stores hold an flock() on the
+ * file and publish the key of an entry after its answer.
+ *
+ * The engine is only started on the first miss, and the moves answered
+ * from the cache are played on it before it is asked anything. It never
+ * sees time_left, so its answers must not depend on the clock. The hits
+ * and misses of a run are written to stderr at exit, those of all runs
+ * are kept in the file and shown by --stats.
+ */
+
+#define CACHE_MAGIC 0x3148434143505447ULL
+#define DEFAULT_ENTRIES (1 << 20)
+#define ANSWER_SIZE 24
+#define MAX_PROBES 64
+
+pcg32_random_t rng;
+
+typedef struct cache_header {
+  uint64_t magic;
+  uint64_t entries;
+  uint64_t used;
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t reserved[3];
+} cache_header;
+
+/* An entry is free while its key is 0. */
+typedef struct cache_entry {
+  uint64_t key;
+  char answer[ANSWER_SIZE];
+} cache_entry;
+
+typedef struct move {
+  int color, i, j;
+  /* Hash of the moves up to and including this one. */
+  uint64_t history;
+} move;
+
+static int cache_fd = -1;
+static cache_header *header;
+static cache_entry *table;
+static uint64_t engine_hash;
+static long hits = 0, misses = 0;
+
+static char **engine_argv;
+static pid_t engine_pid = 0;
+static FILE *to_engine, *from_engine;
+/* What the engine has been told: its size is 0 until it is cleared,
+ * and engine_moves of the moves are played on it.
+ */
+static int engine_size = 0;
+static float engine_komi = -1;
+static int engine_moves = 0;
+static char time_settings[64] = "";
+
+static board_t game;
+static float komi = 6.5;
+static move *moves = NULL;
+static int num_moves = 0, max_moves = 0;
+
+static uint64_t
+mix(uint64_t x)
+{
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
+
+static uint64_t
+history(void)
+{
+  return num_moves > 0 ? moves[num_moves - 1].history : 0x9e3779b97f4a7c15ULL;
+}
+
+/* The key of a question to the engine after the current moves. */
+static uint64_t
+cache_key(const char *command, int color)
+{
+  uint64_t key = engine_hash;
+  const char *c;
+
+  for (c = command; *c; c++)
+    key = (key ^ (unsigned char)*c) * 0x100000001b3ULL;
+  key = mix(key ^ game.board_size);
+  key = mix(key ^ (uint64_t)(int)(komi * 2));
+  key = mix(key ^ history());
+  key = mix(key ^ color);
+  return key ? key : 1;
+}
+
+/* Map the cache file, creating it with the given number of entries if
+ * it is new. Returns 0 on failure.
+ */
+static int
+open_cache(const char *path, uint64_t entries, int create)
+{
+  cache_header h;
+  struct stat st;
+  size_t size;
+  void *map;
+
+  cache_fd = open(path, create ? O_RDWR | O_CREAT | O_CLOEXEC : O_RDWR | O_CLOEXEC, 0644);
+  if (cache_fd < 0) {
+    perror(path);
+    return 0;
+  }
+
+  flock(cache_fd, LOCK_EX);
+  fstat(cache_fd, &st);
+  if (st.st_size == 0) {
+    memset(&h, 0, sizeof(h));
+    h.magic = CACHE_MAGIC;
+    h.entries = entries;
+    if (ftruncate(cache_fd, sizeof(h) + entries * sizeof(cache_entry))
+	|| pwrite(cache_fd, &h, sizeof(h), 0) != sizeof(h)) {
+      perror(path);
+      flock(cache_fd, LOCK_UN);
+      return 0;
+    }
+  }
+  else if (pread(cache_fd, &h, sizeof(h), 0) != sizeof(h)
+	   || h.magic != CACHE_MAGIC
+	   || (uint64_t)st.st_size != sizeof(h) + h.entries * sizeof(cache_entry)) {
+    fprintf(stderr, "%s: not a gtpcache file\n", path);
+    flock(cache_fd, LOCK_UN);
+    return 0;
+  }
+  flock(cache_fd, LOCK_UN);
+
+  size = sizeof(h) + h.entries * sizeof(cache_entry);
+  map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, cache_fd, 0);
+  if (map == MAP_FAILED) {
+    perror(path);
+    return 0;
+  }
+  header = map;
+  table = (cache_entry *)(header + 1);
+  return 1;
+}
+
+/* Copy the cached answer to a question into answer. Returns whether
+ * there was one.
+ */
+static int
+cache_lookup(uint64_t key, char *answer)
+{
+  uint64_t k;
+  int probe;
+
+  if (header == NULL)
+    return 0;
+  for (probe = 0; probe < MAX_PROBES; probe++) {
+    cache_entry *e = &table[(key + probe) % header->entries];
+    k = __atomic_load_n(&e->key, __ATOMIC_ACQUIRE);
+    if (k == 0)
+      break;
+    if (k == key) {
+      memcpy(answer, e->answer, ANSWER_SIZE);
+      __atomic_fetch_add(&header->hits, 1, __ATOMIC_RELAXED);
+      hits++;
+      return 1;
+    }
+  }
+  __atomic_fetch_add(&header->misses, 1, __ATOMIC_RELAXED);
+  misses++;
+  return 0;
+}
+
+/* Answers which do not fit, and anything once the table is nine tenths
+ * full, are not stored.
+ */
+static void
+cache_store(uint64_t key, const char *answer)
+{
+  int probe;
+
+  if (header == NULL || strlen(answer) >= ANSWER_SIZE)
+    return;
+
+  flock(cache_fd, LOCK_EX);
+  for (probe = 0; probe < MAX_PROBES && header->used < header->entries / 10 * 9; probe++) {
+    cache_entry *e = &table[(key + probe) % header->entries];
+    if (e->key == key)
+      break;
+    if (e->key == 0) {
+      memset(e->answer, 0, ANSWER_SIZE);
+      strcpy(e->answer, answer);
+      __atomic_store_n(&e->key, key, __ATOMIC_RELEASE);
+      header->used++;
+      break;
+    }
+  }
+  flock(cache_fd, LOCK_UN);
+}
+
+static void
+start_engine(void)
+{
+  int to[2], from[2];
+
+  if (pipe(to) || pipe(from)) {
+    perror("pipe");
+    exit(1);
+  }
+  engine_pid = fork();
+  if (engine_pid < 0) {
+    perror("fork");
+    exit(1);
+  }
+  if (engine_pid == 0) {
+    dup2(to[0], 0);
+    dup2(from[1], 1);
+    close(to[0]);
+    close(to[1]);
+    close(from[0]);
+    close(from[1]);
+    execvp(engine_argv[0], engine_argv);
+    perror(engine_argv[0]);
+    _exit(127);
+  }
+  close(to[0]);
+  close(from[1]);
+  to_engine = fdopen(to[1], "w");
+  from_engine = fdopen(from[0], "r");
+}
+
+/* Send a command to the engine and copy the text of its response into
+ * response. Returns whether it succeeded. The proxy gives up when the
+ * engine is gone.
+ */
+static int
+engine_command(char *response, size_t size, const char *format, ...)
+{
+  char line[GTP_BUFSIZE];
+  size_t length = 0;
+  int status = -1;
+  va_list ap;
+
+  va_start(ap, format);
+  vfprintf(to_engine, format, ap);
+  va_end(ap);
+  fputc('\n', to_engine);
+  fflush(to_engine);
+
+  response[0] = 0;
+  while (fgets(line, sizeof(line), from_engine) != NULL) {
+    char *text = line;
+    line[strcspn(line, "\r\n")] = 0;
+    if (status == -1) {
+      if (line[0] != '=' && line[0] != '?')
+	continue;
+      status = line[0] == '=' ? GTP_SUCCESS : GTP_FAILURE;
+      text++;
+      while (*text >= '0' && *text <= '9')
+	text++;
+      while (*text == ' ')
+	text++;
+    }
+    else if (line[0] == 0)
+      return status == GTP_SUCCESS;
+    else if (length + 1 < size)
+      response[length++] = '\n';
+    length += snprintf(response + length, size - length, "%s", text);
+    if (length >= size)
+      length = size - 1;
+  }
+
+  fprintf(stderr, "gtpcache: %s exited\n", engine_argv[0]);
+  exit(1);
+}
+
+/* A vertex the way GTP writes it, skipping the letter I. */
+static void
+vertex(int i, int j, char *buf, size_t size)
+{
+  if (i == -1)
+    snprintf(buf, size, "pass");
+  else
+    snprintf(buf, size, "%c%d", 'A' + j + (j >= 8), game.board_size - i);
+}
+
+/* Bring the engine up to the current position, starting it if needed. */
+static void
+sync_engine(void)
+{
+  char response[256];
+  char buf[16];
+
+  if (engine_pid == 0)
+    start_engine();
+  if (engine_size != game.board_size || engine_moves > num_moves) {
+    if (!engine_command(response, sizeof(response), "boardsize %d", game.board_size)
+	|| !engine_command(response, sizeof(response), "clear_board")) {
+      fprintf(stderr, "gtpcache: %s cannot play on %d\n", engine_argv[0], game.board_size);
+      exit(1);
+    }
+    if (time_settings[0])
+      engine_command(response, sizeof(response), "time_settings %s", time_settings);
+    engine_size = game.board_size;
+    engine_moves = 0;
+  }
+  if (engine_komi != komi) {
+    engine_command(response, sizeof(response), "komi %.1f", komi);
+    engine_komi = komi;
+  }
+  for (; engine_moves < num_moves; engine_moves++) {
+    move *m = &moves[engine_moves];
+    vertex(m->i, m->j, buf, sizeof(buf));
+    engine_command(response, sizeof(response), "play %c %s",
+		   m->color == BLACK ? 'b' : 'w', buf);
+  }
+}
+
+static void
+add_move(int color, int i, int j)
+{
+  move *m;
+
+  if (num_moves == max_moves) {
+    max_moves = max_moves ? 2 * max_moves : 256;
+    moves = realloc(moves, max_moves * sizeof(move));
+  }
+  m = &moves[num_moves];
+  m->color = color;
+  m->i = i;
+  m->j = j;
+  m->history = mix(history() ^ ((uint64_t)color << 32) ^ (uint64_t)(i == -1 ? -1 : POS(&game, i, j)));
+  num_moves++;
+  play_move(&game, i, j, color);
+}
+
+/* Start over on an empty board, which the engine gets on the next
+ * miss.
+ */
+static void
+new_game(void)
+{
+  clear_board(&game);
+  num_moves = 0;
+  engine_size = 0;
+}
+
+/* An answer of the engine to the command for color, either cached
+ * under key or asked for. Returns whether it succeeded.
+ */
+static int
+ask(const char *command, int color, int play, char *answer, size_t size)
+{
+  uint64_t key = cache_key(command, color);
+  char cached[ANSWER_SIZE];
+
+  if (cache_lookup(key, cached)) {
+    snprintf(answer, size, "%s", cached);
+    return 1;
+  }
+
+  if (play)
+    sync_engine();
+  else if (engine_pid == 0)
+    start_engine();
+  if (!engine_command(answer, size, "%s", command))
+    return 0;
+  if (play)
+    engine_moves = num_moves + 1;
+  cache_store(key, answer);
+  return 1;
+}
+
+static int
+gtp_protocol_version(char *s)
+{
+  return gtp_success("2");
+}
+
+static int
+gtp_name(char *s)
+{
+  char answer[256];
+
+  if (!ask("name", EMPTY, 0, answer, sizeof(answer)))
+    return gtp_failure("%s", answer);
+  return gtp_success("%s", answer);
+}
+
+static int
+gtp_version(char *s)
+{
+  char answer[256];
+
+  if (!ask("version", EMPTY, 0, answer, sizeof(answer)))
+    return gtp_failure("%s", answer);
+  return gtp_success("%s", answer);
+}
+
+static int gtp_known_command(char *s);
+static int gtp_list_commands(char *s);
+
+static int
+gtp_quit(char *s)
+{
+  gtp_success("");
+  return GTP_QUIT;
+}
+
+static int
+gtp_boardsize(char *s)
+{
+  int boardsize;
+
+  if (sscanf(s, "%d", &boardsize) < 1)
+    return gtp_failure("boardsize not an integer");
+
+  if (boardsize < 2 || boardsize > MAX_BOARD)
+    return gtp_failure("unacceptable size");
+
+  set_board_size(&game, boardsize);
+  gtp_internal_set_boardsize(boardsize);
+  new_game();
+  return gtp_success("");
+}
+
+static int
+gtp_clear_board(char *s)
+{
+  new_game();
+  return gtp_success("");
+}
+
+static int
+gtp_komi(char *s)
+{
+  if (sscanf(s, "%f", &komi) < 1)
+    return gtp_failure("komi not a float");
+
+  return gtp_success("");
+}
+
+static int
+gtp_time_settings(char *s)
+{
+  snprintf(time_settings, sizeof(time_settings), "%s", s);
+  time_settings[strcspn(time_settings, "\n")] = 0;
+  engine_size = 0;
+  return gtp_success("");
+}
+
+static int
+gtp_time_left(char *s)
+{
+  return gtp_success("");
+}
+
+static int
+gtp_play(char *s)
+{
+  int i, j;
+  int color;
+
+  if (!gtp_decode_move(s, &color, &i, &j))
+    return gtp_failure("invalid color or coordinate");
+
+  if (!legal_move(&game, i, j, color))
+    return gtp_failure("illegal move");
+
+  add_move(color, i, j);
+  return gtp_success("");
+}
+
+static int
+gtp_undo(char *s)
+{
+  if (num_moves == 0 || !unmake_move(&game))
+    return gtp_failure("cannot undo");
+
+  num_moves--;
+  return gtp_success("");
+}
+
+static int
+gtp_genmove(char *s)
+{
+  char command[16], answer[256];
+  int color, i, j;
+
+  if (!gtp_decode_color(s, &color))
+    return gtp_failure("invalid color");
+
+  snprintf(command, sizeof(command), "genmove %c", color == BLACK ? 'b' : 'w');
+  if (!ask(command, color, 1, answer, sizeof(answer)))
+    return gtp_failure("%s", answer);
+
+  if (!strcasecmp(answer, "pass"))
+    add_move(color, -1, -1);
+  else if (gtp_decode_coord(answer, &i, &j) && legal_move(&game, i, j, color))
+    add_move(color, i, j);
+  else
+    /* Resigned, or a move we cannot follow. Ask the engine next time. */
+    engine_size = 0;
+
+  return gtp_success("%s", answer);
+}
+
+static int
+gtp_final_score(char *s)
+{
+  char answer[256];
+
+  sync_engine();
+  if (!engine_command(answer, sizeof(answer), "final_score"))
+    return gtp_failure("%s", answer);
+  return gtp_success("%s", answer);
+}
+
+static struct gtp_command commands[] = {
+  {"protocol_version",    gtp_protocol_version},
+  {"name",                gtp_name},
+  {"version",             gtp_version},
+  {"known_command",       gtp_known_command},
+  {"list_commands",       gtp_list_commands},
+  {"quit",                gtp_quit},
+  {"boardsize",           gtp_boardsize},
+  {"clear_board",         gtp_clear_board},
+  {"komi",                gtp_komi},
+  {"time_settings",       gtp_time_settings},
+  {"time_left",           gtp_time_left},
+  {"play",                gtp_play},
+  {"undo",                gtp_undo},
+  {"genmove",             gtp_genmove},
+  {"final_score",         gtp_final_score},
+  {NULL,                  NULL}
+};
+
+static int
+gtp_known_command(char *s)
+{
+  int i;
+  char command_name[GTP_BUFSIZE];
+
+  if (sscanf(s, "%s", command_name) < 1)
+    return gtp_success("false");
+
+  for (i = 0; commands[i].name; i++)
+    if (!strcmp(command_name, commands[i].name))
+      return gtp_success("true");
+
+  return gtp_success("false");
+}
+
+static int
+gtp_list_commands(char *s)
+{
+  int i;
+
+  gtp_start_response(GTP_SUCCESS);
+
+  for (i = 0; commands[i].name; i++)
+    gtp_printf("%s\n", commands[i].name);
+
+  gtp_printf("\n");
+  return GTP_OK;
+}
+
+static void
+usage(void)
+{
+  fprintf(stderr, "Usage: gtpcache [--cache file] [--entries n] engine args ...\n"
+	  "       gtpcache --stats file\n");
+  exit(1);
+}
+
+static void
+print_stats(FILE *fd, const char *what, uint64_t h, uint64_t m)
+{
+  fprintf(fd, "%s%llu hits, %llu misses (%.1f%%)", what,
+	  (unsigned long long)h, (unsigned long long)m,
+	  h + m > 0 ? 100.0 * h / (h + m) : 0.0);
+}
+
+int
+main(int argc, char **argv)
+{
+  const char *path = "gtp.cache";
+  uint64_t entries = DEFAULT_ENTRIES;
+  int k;
+  char *c;
+
+  if (argc == 3 && !strcmp(argv[1], "--stats")) {
+    if (!open_cache(argv[2], 0, 0))
+      exit(1);
+    print_stats(stdout, "", header->hits, header->misses);
+    printf(", %llu of %llu entries used\n", (unsigned long long)header->used,
+	   (unsigned long long)header->entries);
+    return 0;
+  }
+
+  for (k = 1; k + 1 < argc && !strncmp(argv[k], "--", 2); k += 2) {
+    if (!strcmp(argv[k], "--cache"))
+      path = argv[k + 1];
+    else if (!strcmp(argv[k], "--entries"))
+      entries = strtoull(argv[k + 1], NULL, 10);
+    else
+      usage();
+  }
+  if (k == argc || entries == 0)
+    usage();
+  engine_argv = argv + k;
+
+  /* Answers of other engines, or of other options, never match. */
+  engine_hash = 0xcbf29ce484222325ULL;
+  for (; k < argc; k++)
+    for (c = argv[k]; ; c++) {
+      engine_hash = (engine_hash ^ (unsigned char)*c) * 0x100000001b3ULL;
+      if (*c == 0)
+	break;
+    }
+
+  if (!open_cache(path, entries, 1))
+    exit(1);
+
+  signal(SIGPIPE, SIG_IGN);
+  init_brown(&game);
+  set_board_size(&game, 19);
+  gtp_internal_set_boardsize(19);
+  clear_board(&game);
+  setvbuf(stdout, NULL, _IOFBF, BUFSIZ);
+
+  gtp_main_loop(commands, stdin, NULL);
+
+  if (engine_pid > 0) {
+    fprintf(to_engine, "quit\n");
+    fclose(to_engine);
+    waitpid(engine_pid, NULL, 0);
+  }
+  print_stats(stderr, "gtpcache: ", hits, misses);
+  print_stats(stderr, ", all runs ", header->hits, header->misses);
+  fprintf(stderr, "\n");
+  free_brown(&game);
+  free(moves);
+  return 0;
+}
@@ -33,14 +33,18 @@
  * without prior written authorization of the copyright holder.  *
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>  /* for rand() and srand() */
 #include <string.h>
+#include <unistd.h>
 
 #include "brown.h"
 #include "generate_move.h"
 #include "gtp.h"
 #include "interface.h"
+#include "match.h"
+#include "score.h"
 
 /* Forward declarations. */
 static int gtp_protocol_version(char *s);
@@ -56,10 +60,20 @@ static int gtp_fixed_handicap(char *s);
 static int gtp_place_free_handicap(char *s);
 static int gtp_set_free_handicap(char *s);
 static int gtp_play(char *s);
+static int gtp_undo(char *s);
 static int gtp_genmove(char *s);
 static int gtp_final_score(char *s);
 static int gtp_final_status_list(char *s);
 static int gtp_showboard(char *s);
+static int gtp_hash(char *s);
+static int gtp_load_network(char *s);
+static int gtp_board_new(char *s);
+static int gtp_board_free(char *s);
+static int gtp_board_clear(char *s);
+static int gtp_board_play(char *s);
+static int gtp_board_genmove(char *s);
+static int gtp_board_final_score(char *s);
+static int gtp_genmove_batch(char *s);
 
 /* List of known commands. */
 static struct gtp_command commands[] = {
@@ -76,63 +90,200 @@ static struct gtp_command commands[] = {
   {"place_free_handicap", gtp_place_free_handicap},
   {"set_free_handicap",   gtp_set_free_handicap},
   {"play",            	  gtp_play},
+  {"undo",                gtp_undo},
   {"genmove",             gtp_genmove},
   {"final_score",         gtp_final_score},
   {"final_status_list",   gtp_final_status_list},
   {"showboard",        	  gtp_showboard},
+  {"evo-hash",            gtp_hash},
+  {"evo-load_network",    gtp_load_network},
+  {"evo-board_new",       gtp_board_new},
+  {"evo-board_free",      gtp_board_free},
+  {"evo-board_clear",     gtp_board_clear},
+  {"evo-board_play",      gtp_board_play},
+  {"evo-board_genmove",   gtp_board_genmove},
+  {"evo-board_final_score", gtp_board_final_score},
+  {"evo-genmove_batch",   gtp_genmove_batch},
   {NULL,                  NULL}
 };
 
-genann *ann = NULL;
-double *ann_inputs = NULL;
+/* The GTP frontend plays a single game, with the nets given on the
+ * command line as its player. As a referee it loads no nets and only
+ * keeps track of the game and scores it.
+ */
+static board_t game;
+static player_t player;
+static genann **anns = NULL;
+static int ann_count = 0;
+static int referee = 0;
+static char *program;
+
+/* Boards created with evo-board_new, indexed by their id. Freed ids
+ * are NULL until they are handed out again.
+ */
+static board_t **boards = NULL;
+static int num_boards = 0;
 
-void allocate_ann(char *ann_save_file) {
+/* Load a net from a file, or make a random one for the board size if
+ * there is no file.
+ */
+genann *load_ann(char *ann_save_file, int board_size) {
   int points = board_size * board_size;
   // Komi as input
   int input_size = points + 1;
   // Allow pass move as output
   int output_size = points + 1;
+  genann *net;
 
   fprintf(stderr, "Loading NN ...");
 
-  if (ann != NULL) genann_free(ann);
   if (ann_save_file == NULL) {
-    ann = genann_init(input_size, 5, points * 10, output_size);
+    net = genann_init(input_size, 5, points * 10, output_size);
   } else {
     FILE *fd = fopen(ann_save_file, "rb");
-    ann = genann_binary_read(fd);
+    if (fd == NULL) {
+      perror(ann_save_file);
+      exit(1);
+    }
+    net = genann_binary_read(fd);
     fclose(fd);
+    if (net == NULL) exit(1);
   }
 
   fprintf(
     stderr,
     "\rLoaded NN with %d inputs, %d outputs, %d layers, %d neurons per layer, %d total neurons\n",
-    ann->inputs,
-    ann->outputs,
-    ann->hidden_layers,
-    ann->hidden,
-    ann->total_weights
+    net->inputs,
+    net->outputs,
+    net->hidden_layers,
+    net->hidden,
+    net->total_weights
   );
+
+  return net;
 }
 
-void allocate_ann_inputs() {
-  if (ann_inputs != NULL) free(ann_inputs);
-  ann_inputs = malloc(ann->inputs * sizeof(double));
+/* Load count nets, or a random one if count is 0. */
+static void allocate_anns(int count, char **ann_save_files) {
+  int k;
+
+  ann_count = count > 0 ? count : 1;
+  anns = malloc(ann_count * sizeof(genann *));
+  for (k = 0; k < ann_count; k++)
+    anns[k] = load_ann(count > 0 ? ann_save_files[k] : NULL, game.board_size);
 }
 
-int boot(int argc, char **argv) {
-  /* Make sure that stdout is not block buffered. */
-  setbuf(stdout, NULL);
+/* Pick up the kernel configuration written by autotune. The profile is
+ * looked for next to the executable, unless EVO_TUNING names another file.
+ */
+void load_tuning(char *argv0, genann *net) {
+  char path[GTP_BUFSIZE];
+  char *env = getenv("EVO_TUNING");
+  char *slash = strrchr(argv0, '/');
+
+  if (env != NULL)
+    snprintf(path, sizeof(path), "%s", env);
+  else if (slash != NULL)
+    snprintf(path, sizeof(path), "%.*s/tuning.profile", (int)(slash - argv0), argv0);
+  else
+    snprintf(path, sizeof(path), "tuning.profile");
 
-  /* Inform the GTP utility functions about the initial board size. */
-  gtp_internal_set_boardsize(board_size);
+  FILE *fd = fopen(path, "r");
+  if (fd == NULL) return;
+
+  if (genann_tuning_read(net, fd))
+    fprintf(stderr, "Using tuning from %s: tile %d, batch %d\n", path, net->tuning.tile, net->tuning.batch);
+  fclose(fd);
+}
+
+static void usage(void) {
+  fprintf(stderr, "Usage: evo [--combine mean|vote|weighted] [--weights w1,w2,...] [--threads n] [ann ...]\n"
+                  "       evo --referee\n");
+  exit(1);
+}
+
+/* Parse the options in front of the nets. Returns the index of the
+ * first net.
+ */
+static int parse_options(int argc, char **argv, char **weights, int *combine, int *threads) {
+  int k = 1;
+  int combine_given = 0;
+
+  *threads = sysconf(_SC_NPROCESSORS_ONLN);
+  while (k < argc && !strncmp(argv[k], "--", 2)) {
+    // The only option without a value
+    if (!strcmp(argv[k], "--referee")) {
+      referee = 1;
+      k++;
+      continue;
+    }
+    if (k + 1 >= argc) usage();
+    if (!strcmp(argv[k], "--combine")) {
+      combine_given = 1;
+      if (!strcmp(argv[k + 1], "mean")) *combine = COMBINE_MEAN;
+      else if (!strcmp(argv[k + 1], "vote")) *combine = COMBINE_VOTE;
+      else if (!strcmp(argv[k + 1], "weighted")) *combine = COMBINE_WEIGHTED;
+      else usage();
+    } else if (!strcmp(argv[k], "--weights")) {
+      *weights = argv[k + 1];
+    } else if (!strcmp(argv[k], "--threads")) {
+      *threads = atoi(argv[k + 1]);
+    } else {
+      usage();
+    }
+    k += 2;
+  }
+
+  // Weights without a mode mean a weighted mean
+  if (*weights != NULL && !combine_given) *combine = COMBINE_WEIGHTED;
+  return k;
+}
+
+/* One weight per net, all 1 unless given on the command line. */
+static void set_ann_weights(char *weights) {
+  int k;
+
+  if (weights == NULL) return;
+  for (k = 0; k < ann_count; k++) {
+    char *end;
+    player.weights[k] = strtod(weights, &end);
+    if (end == weights || player.weights[k] <= 0) usage();
+    weights = *end == ',' ? end + 1 : end;
+  }
+  if (*weights != '\0') usage();
+}
 
-  // Initialize the NN
-  allocate_ann(argc > 1 ? argv[1] : NULL);
-  allocate_ann_inputs();
+int boot(int argc, char **argv) {
+  char *weights = NULL;
+  int combine = COMBINE_MEAN, threads;
+  int first_ann, k;
+
+  /* Block buffer stdout. gtp_main_loop() flushes it after every
+   * response, so each response goes out in a single write.
+   */
+  setvbuf(stdout, NULL, _IOFBF, BUFSIZ);
+  program = argv[0];
 
   /* Initialize the board. */
-  init_brown();
+  init_brown(&game);
+
+  /* Inform the GTP utility functions about the initial board size. */
+  gtp_internal_set_boardsize(game.board_size);
+
+  // Initialize the NNs
+  first_ann = parse_options(argc, argv, &weights, &combine, &threads);
+  if (referee) {
+    if (first_ann < argc) usage();
+    gtp_main_loop(commands, stdin, NULL);
+    return 0;
+  }
+  allocate_anns(argc - first_ann, argv + first_ann);
+  for (k = 0; k < ann_count; k++)
+    load_tuning(argv[0], anns[k]);
+  init_player(&player, anns, ann_count);
+  player.combine = combine;
+  player.threads = threads;
+  set_ann_weights(weights);
 
   /* Process GTP commands. */
   gtp_main_loop(commands, stdin, NULL);
@@ -210,9 +361,8 @@ gtp_boardsize(char *s)
   if (boardsize < MIN_BOARD || boardsize > MAX_BOARD)
     return gtp_failure("unacceptable size");
 
-  board_size = boardsize;
+  set_board_size(&game, boardsize);
   gtp_internal_set_boardsize(boardsize);
-  init_brown();
 
   return gtp_success("");
 }
@@ -220,14 +370,14 @@ gtp_boardsize(char *s)
 static int
 gtp_clear_board(char *s)
 {
-  clear_board();
+  clear_board(&game);
   return gtp_success("");
 }
 
 static int
 gtp_komi(char *s)
 {
-  if (sscanf(s, "%f", &komi) < 1)
+  if (sscanf(s, "%f", &game.komi) < 1)
     return gtp_failure("komi not a float");
 
   return gtp_success("");
@@ -241,27 +391,30 @@ place_handicap(char *s, int fixed)
   int m, n;
   int first_stone = 1;
 
-  if (!board_empty())
+  if (!board_empty(&game))
     return gtp_failure("board not empty");
 
+  if (!fixed && referee)
+    return gtp_failure("referee does not place stones");
+
   if (sscanf(s, "%d", &handicap) < 1)
     return gtp_failure("handicap not an integer");
 
   if (handicap < 2)
     return gtp_failure("invalid handicap");
 
-  if (fixed && !valid_fixed_handicap(handicap))
+  if (fixed && !valid_fixed_handicap(&game, handicap))
     return gtp_failure("invalid handicap");
 
   if (fixed)
-    place_fixed_handicap(handicap);
+    place_fixed_handicap(&game, handicap);
   else
-    place_free_handicap(handicap);
+    place_free_handicap(&game, &player, handicap);
 
   gtp_start_response(GTP_SUCCESS);
-  for (m = 0; m < board_size; m++)
-    for (n = 0; n < board_size; n++)
-      if (get_board(m, n) != EMPTY) {
+  for (m = 0; m < game.board_size; m++)
+    for (n = 0; n < game.board_size; n++)
+      if (get_board(&game, m, n) != EMPTY) {
 	if (first_stone)
 	  first_stone = 0;
 	else
@@ -290,28 +443,28 @@ gtp_set_free_handicap(char *s)
   int n;
   int handicap = 0;
 
-  if (!board_empty())
+  if (!board_empty(&game))
     return gtp_failure("board not empty");
 
   while ((n = gtp_decode_coord(s, &i, &j)) > 0) {
     s += n;
 
-    if (get_board(i, j) != EMPTY) {
-      clear_board();
+    if (get_board(&game, i, j) != EMPTY) {
+      clear_board(&game);
       return gtp_failure("repeated vertex");
     }
 
-    play_move(i, j, BLACK);
+    play_move(&game, i, j, BLACK);
     handicap++;
   }
 
   if (sscanf(s, "%*s") != EOF) {
-      clear_board();
+      clear_board(&game);
       return gtp_failure("invalid coordinate");
   }
 
-  if (handicap < 2 || handicap >= board_size * board_size) {
-      clear_board();
+  if (handicap < 2 || handicap >= game.board_size * game.board_size) {
+      clear_board(&game);
       return gtp_failure("invalid handicap");
   }
 
@@ -327,10 +480,19 @@ gtp_play(char *s)
   if (!gtp_decode_move(s, &color, &i, &j))
     return gtp_failure("invalid color or coordinate");
 
-  if (!legal_move(i, j, color))
+  if (!legal_move(&game, i, j, color))
     return gtp_failure("illegal move");
 
-  play_move(i, j, color);
+  play_move(&game, i, j, color);
+  return gtp_success("");
+}
+
+static int
+gtp_undo(char *s)
+{
+  if (!unmake_move(&game))
+    return gtp_failure("cannot undo");
+
   return gtp_success("");
 }
 
@@ -343,44 +505,34 @@ gtp_genmove(char *s)
   if (!gtp_decode_color(s, &color))
     return gtp_failure("invalid color");
 
-  generate_move(&i, &j, color);
-  play_move(i, j, color);
+  if (referee)
+    return gtp_failure("referee does not play");
+
+  generate_move(&game, &player, &i, &j, color);
+  play_move(&game, i, j, color);
 
   gtp_start_response(GTP_SUCCESS);
   gtp_mprintf("%m", i, j);
   return gtp_finish_response();
 }
 
-/* Compute final score. We use area scoring since that is the only
- * option that makes sense for this move generation algorithm.
+/* Compute final score. We use area scoring by the Tromp-Taylor
+ * rules, after taking off the stones which are dead tactically.
  */
 static int
 gtp_final_score(char *s)
 {
-  float score = komi;
-  int i, j;
+  int dead[MAX_BOARD * MAX_BOARD];
+  char result[32];
 
-  compute_final_status();
-  for (i = 0; i < board_size; i++)
-    for (j = 0; j < board_size; j++) {
-      int status = get_final_status(i, j);
-      if (status == BLACK_TERRITORY)
-	score--;
-      else if (status == WHITE_TERRITORY)
-	score++;
-      else if ((status == ALIVE) ^ (get_board(i, j) == WHITE))
-	score--;
-      else
-	score++;
-    }
-
-  if (score > 0.0)
-    return gtp_success("W+%3.1f", score);
-  if (score < 0.0)
-    return gtp_success("B+%3.1f", -score);
-  return gtp_success("0");
+  find_dead_stones(&game, dead);
+  format_result(tromp_taylor_score(&game, dead), result, sizeof(result));
+  return gtp_success("%s", result);
 }
 
+/* Stones are dead if find_dead_stones() says so and alive otherwise.
+ * There is no seki.
+ */
 static int
 gtp_final_status_list(char *s)
 {
@@ -388,6 +540,8 @@ gtp_final_status_list(char *s)
   int i, j;
   int status = UNKNOWN;
   char status_string[GTP_BUFSIZE];
+  int dead[MAX_BOARD * MAX_BOARD];
+  int listed[MAX_BOARD * MAX_BOARD];
   int first_string;
 
   if (sscanf(s, "%s %n", status_string, &n) != 1)
@@ -402,29 +556,36 @@ gtp_final_status_list(char *s)
   else
     return gtp_failure("invalid status");
 
-  compute_final_status();
+  find_dead_stones(&game, dead);
+  memset(listed, 0, sizeof(listed));
 
   gtp_start_response(GTP_SUCCESS);
 
   first_string = 1;
-  for (i = 0; i < board_size; i++)
-    for (j = 0; j < board_size; j++)
-      if (get_final_status(i, j) == status) {
-	int k;
-	int stonei[MAX_BOARD * MAX_BOARD];
-	int stonej[MAX_BOARD * MAX_BOARD];
-	int num_stones = get_string(i, j, stonei, stonej);
-	/* Clear the status so we don't find the string again. */
-	for (k = 0; k < num_stones; k++)
-	  set_final_status(stonei[k], stonej[k], UNKNOWN);
-
-	if (first_string)
-	  first_string = 0;
-	else
-	  gtp_printf("\n");
+  for (i = 0; i < game.board_size; i++)
+    for (j = 0; j < game.board_size; j++) {
+      int pos = POS(&game, i, j);
+      int k;
+      int stonei[MAX_BOARD * MAX_BOARD];
+      int stonej[MAX_BOARD * MAX_BOARD];
+      int num_stones;
+
+      if (get_board(&game, i, j) == EMPTY || listed[pos]
+	  || status != (dead[pos] ? DEAD : ALIVE))
+	continue;
+
+      /* Mark the string so we don't find it again. */
+      num_stones = get_string(&game, i, j, stonei, stonej);
+      for (k = 0; k < num_stones; k++)
+	listed[POS(&game, stonei[k], stonej[k])] = 1;
+
+      if (first_string)
+	first_string = 0;
+      else
+	gtp_printf("\n");
 
-	gtp_print_vertices(num_stones, stonei, stonej);
-      }
+      gtp_print_vertices(num_stones, stonei, stonej);
+    }
 
   return gtp_finish_response();
 }
@@ -436,7 +597,7 @@ letters(void)
   int i;
 
   printf("  ");
-  for (i = 0; i < board_size; i++)
+  for (i = 0; i < game.board_size; i++)
     printf(" %c", 'A' + i + (i >= 8));
 }
 
@@ -451,16 +612,341 @@ gtp_showboard(char *s)
 
   letters();
 
-  for (i = 0; i < board_size; i++) {
-    printf("\n%2d", board_size - i);
+  for (i = 0; i < game.board_size; i++) {
+    printf("\n%2d", game.board_size - i);
 
-    for (j = 0; j < board_size; j++)
-      printf(" %c", symbols[get_board(i, j)]);
+    for (j = 0; j < game.board_size; j++)
+      printf(" %c", symbols[get_board(&game, i, j)]);
 
-    printf(" %d", board_size - i);
+    printf(" %d", game.board_size - i);
   }
 
   printf("\n");
   letters();
   return gtp_finish_response();
 }
+
+/* Zobrist hash of the current position and color to move, as 16 hex
+ * digits. It is the same for the same position in every run, so
+ * external tools can use it to key caches.
+ */
+static int
+gtp_hash(char *s)
+{
+  return gtp_success("%016" PRIx64, board_hash(&game));
+}
+
+/* Replace the nets of the player with the nets in the given files, so
+ * that one process can play games with different nets. A net with the
+ * same topology as the one it replaces is read into its memory.
+ */
+static int
+gtp_load_network(char *s)
+{
+  char path[GTP_BUFSIZE];
+  FILE *files[GTP_BUFSIZE / 2];
+  genann **loaded;
+  double *weights;
+  int count = 0, changed = 0;
+  int n, k;
+
+  if (referee)
+    return gtp_failure("referee has no nets");
+
+  while (sscanf(s, "%s%n", path, &n) == 1) {
+    s += n;
+    files[count] = fopen(path, "rb");
+    if (files[count] == NULL) {
+      while (count > 0)
+	fclose(files[--count]);
+      return gtp_failure("cannot open %s", path);
+    }
+    count++;
+  }
+  if (count == 0)
+    return gtp_failure("missing file");
+
+  loaded = malloc(count * sizeof(genann *));
+  for (k = 0; k < count; k++) {
+    if (k < ann_count && genann_binary_read_into(anns[k], files[k])) {
+      loaded[k] = anns[k];
+    }
+    else {
+      rewind(files[k]);
+      loaded[k] = genann_binary_read(files[k]);
+      if (loaded[k] != NULL)
+	load_tuning(program, loaded[k]);
+      changed = 1;
+    }
+    fclose(files[k]);
+  }
+
+  for (k = 0; k < count; k++)
+    if (loaded[k] == NULL) {
+      for (n = 0; n < count; n++)
+	if (loaded[n] != NULL && (n >= ann_count || loaded[n] != anns[n]))
+	  genann_free(loaded[n]);
+      free(loaded);
+      return gtp_failure("cannot read net %d", k + 1);
+    }
+
+  /* Nets that were not read into place are no longer needed. */
+  for (k = 0; k < ann_count; k++)
+    if (k >= count || loaded[k] != anns[k])
+      genann_free(anns[k]);
+  free(anns);
+  anns = loaded;
+  player.anns = anns;
+
+  /* The player's buffers depend on the number and shape of the nets. */
+  if (changed || count != ann_count) {
+    int combine = player.combine, threads = player.threads;
+    weights = count == ann_count ? player.weights : NULL;
+    if (weights != NULL)
+      player.weights = NULL;
+    free_player(&player);
+    init_player(&player, anns, count);
+    player.combine = combine;
+    player.threads = threads;
+    if (weights != NULL) {
+      free(player.weights);
+      player.weights = weights;
+    }
+  }
+  ann_count = count;
+
+  return gtp_success("");
+}
+
+/* The extra boards. Each is created with the size and komi of the
+ * game at the time and is addressed by the id evo-board_new returns,
+ * so that a driver can run many games through one process. Vertices
+ * are read and written for the size of the board they belong to.
+ */
+
+/* Read a board id from s. Returns the board, or NULL if there is no
+ * board with that id, and sets *n to the number of characters read.
+ * Coordinates are converted for the size of the board until
+ * end_board_command() is called.
+ */
+static board_t *
+decode_board(char *s, int *n)
+{
+  int id;
+
+  if (sscanf(s, "%d%n", &id, n) < 1 || id < 0 || id >= num_boards
+      || boards[id] == NULL)
+    return NULL;
+
+  gtp_internal_set_boardsize(boards[id]->board_size);
+  return boards[id];
+}
+
+/* Convert coordinates for the game again. */
+static int
+end_board_command(int status)
+{
+  gtp_internal_set_boardsize(game.board_size);
+  return status;
+}
+
+/* Whether the nets have the inputs and outputs for the board. */
+static int
+nets_fit(board_t *b)
+{
+  int size = b->board_size * b->board_size + 1;
+  int k;
+
+  for (k = 0; k < ann_count; k++)
+    if (anns[k]->inputs != size || anns[k]->outputs != size)
+      return 0;
+  return 1;
+}
+
+static int
+gtp_board_new(char *s)
+{
+  board_t *b = malloc(sizeof(board_t));
+  int id;
+
+  init_brown(b);
+  set_board_size(b, game.board_size);
+  b->komi = game.komi;
+
+  for (id = 0; id < num_boards && boards[id] != NULL; id++)
+    ;
+  if (id == num_boards) {
+    num_boards++;
+    boards = realloc(boards, num_boards * sizeof(board_t *));
+  }
+  boards[id] = b;
+
+  return gtp_success("%d", id);
+}
+
+static int
+gtp_board_free(char *s)
+{
+  int n;
+  board_t *b = decode_board(s, &n);
+
+  if (b == NULL)
+    return end_board_command(gtp_failure("unknown board"));
+
+  free_brown(b);
+  free(b);
+  boards[atoi(s)] = NULL;
+  return end_board_command(gtp_success(""));
+}
+
+static int
+gtp_board_clear(char *s)
+{
+  int n;
+  board_t *b = decode_board(s, &n);
+
+  if (b == NULL)
+    return end_board_command(gtp_failure("unknown board"));
+
+  clear_board(b);
+  return end_board_command(gtp_success(""));
+}
+
+static int
+gtp_board_play(char *s)
+{
+  int i, j, n;
+  int color = EMPTY;
+  board_t *b = decode_board(s, &n);
+
+  if (b == NULL)
+    return end_board_command(gtp_failure("unknown board"));
+
+  if (!gtp_decode_move(s + n, &color, &i, &j))
+    return end_board_command(gtp_failure("invalid color or coordinate"));
+
+  if (!legal_move(b, i, j, color))
+    return end_board_command(gtp_failure("illegal move"));
+
+  play_move(b, i, j, color);
+  return end_board_command(gtp_success(""));
+}
+
+static int
+gtp_board_genmove(char *s)
+{
+  int i, j, n;
+  int color = EMPTY;
+  board_t *b = decode_board(s, &n);
+
+  if (b == NULL)
+    return end_board_command(gtp_failure("unknown board"));
+
+  if (!gtp_decode_color(s + n, &color))
+    return end_board_command(gtp_failure("invalid color"));
+
+  if (referee)
+    return end_board_command(gtp_failure("referee does not play"));
+
+  if (!nets_fit(b))
+    return end_board_command(gtp_failure("nets do not fit the board"));
+
+  generate_move(b, &player, &i, &j, color);
+  play_move(b, i, j, color);
+
+  gtp_start_response(GTP_SUCCESS);
+  gtp_mprintf("%m", i, j);
+  return end_board_command(gtp_finish_response());
+}
+
+static int
+gtp_board_final_score(char *s)
+{
+  int n;
+  int dead[MAX_BOARD * MAX_BOARD];
+  char result[32];
+  board_t *b = decode_board(s, &n);
+
+  if (b == NULL)
+    return end_board_command(gtp_failure("unknown board"));
+
+  find_dead_stones(b, dead);
+  format_result(tromp_taylor_score(b, dead), result, sizeof(result));
+  return end_board_command(gtp_success("%s", result));
+}
+
+/* Generate and play a move on every board listed, for the color to
+ * move there, and return the moves in the same order separated by
+ * spaces. With a single net all positions are evaluated in one
+ * batched forward pass. A committee of nets runs board by board.
+ */
+static int
+gtp_genmove_batch(char *s)
+{
+  board_t **batch;
+  int *movei, *movej;
+  int count = 0, n, k, m;
+  int id;
+
+  if (referee)
+    return gtp_failure("referee does not play");
+
+  batch = malloc(GTP_BUFSIZE / 2 * sizeof(board_t *));
+  for (; sscanf(s, "%d%n", &id, &n) == 1; s += n) {
+    if (id < 0 || id >= num_boards || boards[id] == NULL) {
+      free(batch);
+      return gtp_failure("unknown board %d", id);
+    }
+    for (k = 0; k < count; k++)
+      if (batch[k] == boards[id]) {
+	free(batch);
+	return gtp_failure("board %d listed twice", id);
+      }
+    if (!nets_fit(boards[id])) {
+      free(batch);
+      return gtp_failure("nets do not fit board %d", id);
+    }
+    batch[count++] = boards[id];
+  }
+  if (sscanf(s, "%*s") != EOF || count == 0) {
+    free(batch);
+    return gtp_failure("invalid board list");
+  }
+
+  movei = malloc(count * sizeof(int));
+  movej = malloc(count * sizeof(int));
+  if (ann_count == 1) {
+    genann *net = anns[0];
+    double *inputs = malloc(count * net->inputs * sizeof(double));
+    double *outputs = malloc(count * net->outputs * sizeof(double));
+
+    for (k = 0; k < count; k++)
+      generate_ann_inputs(batch[k], batch[k]->to_move,
+			  inputs + k * net->inputs);
+    genann_run_batch(net, count, inputs, outputs);
+    for (k = 0; k < count; k++)
+      find_and_set_best_move(batch[k], &movei[k], &movej[k],
+			     batch[k]->to_move, outputs + k * net->outputs);
+    free(inputs);
+    free(outputs);
+  }
+  else
+    for (k = 0; k < count; k++)
+      generate_move(batch[k], &player, &movei[k], &movej[k],
+		    batch[k]->to_move);
+
+  gtp_start_response(GTP_SUCCESS);
+  for (k = 0; k < count; k++) {
+    m = batch[k]->to_move;
+    play_move(batch[k], movei[k], movej[k], m);
+    gtp_internal_set_boardsize(batch[k]->board_size);
+    if (k > 0)
+      gtp_printf(" ");
+    gtp_mprintf("%m", movei[k], movej[k]);
+  }
+
+  free(batch);
+  free(movei);
+  free(movej);
+  return end_board_command(gtp_finish_response());
+}
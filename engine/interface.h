@@ -36,5 +36,5 @@
 #include "genann.h"
 
 int boot(int argc, char **argv);
-extern genann *ann;
-extern double *ann_inputs;
+genann *load_ann(char *ann_save_file, int board_size);
+void load_tuning(char *argv0, genann *net);
@@ -0,0 +1 @@
+../lib/json.c
\ No newline at end of file
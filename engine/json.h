@@ -0,0 +1 @@
+../lib/json.h
\ No newline at end of file
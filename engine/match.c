@@ -0,0 +1,199 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * This is Evo, a simple go program.                             *
+ *                                                               *
+ * Copyright 2023 by Urban Hafner                                *
+ *           2003 and 2004 by Gunnar Farnebäck.                  *
+ *                                                               *
+ * Permission is hereby granted, free of charge, to any person   *
+ * obtaining a copy of this file gtp.c, to deal in the Software  *
+ * without restriction, including without limitation the rights  *
+ * to use, copy, modify, merge, publish, distribute, and/or      *
+ * sell copies of the Software, and to permit persons to whom    *
+ * the Software is furnished to do so, provided that the above   *
+ * copyright notice(s) and this permission notice appear in all  *
+ * copies of the Software and that both the above copyright      *
+ * notice(s) and this permission notice appear in supporting     *
+ * documentation.                                                *
+ *                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY     *
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE    *
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR       *
+ * PURPOSE AND NONINFRINGEMENT OF THIRD PARTY RIGHTS. IN NO      *
+ * EVENT SHALL THE COPYRIGHT HOLDER OR HOLDERS INCLUDED IN THIS  *
+ * NOTICE BE LIABLE FOR ANY CLAIM, OR ANY SPECIAL INDIRECT OR    *
+ * CONSEQUENTIAL DAMAGES, OR ANY DAMAGES WHATSOEVER RESULTING    *
+ * FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF    *
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT    *
+ * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS       *
+ * SOFTWARE.                                                     *
+ *                                                               *
+ * Except as contained in this notice, the name of a copyright   *
+ * holder shall not be used in advertising or otherwise to       *
+ * promote the sale, use or other dealings in this Software      *
+ * without prior written authorization of the copyright holder.  *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "brown.h"
+#include "generate_move.h"
+#include "match.h"
+#include "score.h"
+
+static double
+now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Play a game on b, which keeps its size and komi, until both players
+ * pass in a row or max_moves moves have been played. Then score it by
+ * area after taking off the dead stones. Unless moves is NULL, it gets
+ * the 1D coordinates of the moves, with -1 for a pass.
+ */
+void
+play_game(board_t *b, player_t *black, player_t *white, int max_moves,
+	  int *moves, game_result *result)
+{
+  int dead[MAX_BOARD * MAX_BOARD];
+  int color = BLACK;
+  int passes = 0;
+
+  clear_board(b);
+  result->moves = 0;
+  result->seconds[WHITE] = 0;
+  result->seconds[BLACK] = 0;
+  result->loser = EMPTY;
+  result->reason = 0;
+  result->message[0] = 0;
+
+  while (passes < 2 && result->moves < max_moves) {
+    player_t *p = color == BLACK ? black : white;
+    double start = now();
+    int i, j;
+
+    generate_move(b, p, &i, &j, color);
+    result->seconds[color] += now() - start;
+    play_move(b, i, j, color);
+
+    if (moves != NULL)
+      moves[result->moves] = i == -1 ? -1 : POS(b, i, j);
+    result->moves++;
+    passes = i == -1 ? passes + 1 : 0;
+    color = OTHER_COLOR(color);
+  }
+
+  find_dead_stones(b, dead);
+  result->score = tromp_taylor_score(b, dead);
+}
+
+/* The result the way the GTP command final_score gives it. */
+void
+format_result(float score, char *buf, size_t size)
+{
+  if (score > 0.0)
+    snprintf(buf, size, "W+%3.1f", score);
+  else if (score < 0.0)
+    snprintf(buf, size, "B+%3.1f", -score);
+  else
+    snprintf(buf, size, "0");
+}
+
+/* The result the way SGF writes it, with W+R, W+T or W+F when black
+ * lost without the game being scored.
+ */
+void
+game_result_string(const game_result *result, char *buf, size_t size)
+{
+  if (result->loser == EMPTY)
+    format_result(result->score, buf, size);
+  else
+    snprintf(buf, size, "%c+%c", result->loser == BLACK ? 'W' : 'B',
+	     result->reason);
+}
+
+/* Write a game played by play_game() as SGF. */
+void
+write_sgf(FILE *fd, board_t *b, const char *black, const char *white,
+	  const int *moves, const game_result *result)
+{
+  char res[32];
+  int m;
+
+  game_result_string(result, res, sizeof(res));
+  fprintf(fd, "(;FF[4]CA[UTF-8]GM[1]SZ[%d]KM[%.1f]PB[%s]PW[%s]RE[%s]\n",
+	  b->board_size, b->komi, black, white, res);
+  for (m = 0; m < result->moves; m++) {
+    fprintf(fd, ";%c[", m % 2 == 0 ? 'B' : 'W');
+    if (moves[m] != -1)
+      fprintf(fd, "%c%c", 'a' + J(b, moves[m]), 'a' + I(b, moves[m]));
+    fprintf(fd, "]%s", m % 10 == 9 ? "\n" : "");
+  }
+  fprintf(fd, ")\n");
+}
+
+/* The file name of a net without directory and extension, which is how
+ * games and players are named.
+ */
+void
+player_name(const char *path, char *name, size_t size)
+{
+  const char *slash = strrchr(path, '/');
+  const char *base = slash != NULL ? slash + 1 : path;
+  const char *dot = strrchr(base, '.');
+  int length = dot != NULL ? (int)(dot - base) : (int)strlen(base);
+
+  snprintf(name, size, "%.*s", length, base);
+}
+
+/* Write a game the way gogui-twogtp does, as prefix.dat with the result
+ * in the last line and as prefix-0.sgf. Returns 0 if a file could not
+ * be written.
+ */
+int
+write_game_files(const char *prefix, board_t *b, const char *black,
+		 const char *white, const int *moves,
+		 const game_result *result)
+{
+  char path[1024];
+  char res[32];
+  char host[64] = "unknown";
+  FILE *fd;
+
+  snprintf(path, sizeof(path), "%s.dat", prefix);
+  fd = fopen(path, "w");
+  if (fd == NULL) {
+    perror(path);
+    return 0;
+  }
+
+  game_result_string(result, res, sizeof(res));
+  gethostname(host, sizeof(host));
+  fprintf(fd, "# Black: %s\n", black);
+  fprintf(fd, "# White: %s\n", white);
+  fprintf(fd, "# Referee: evo\n");
+  fprintf(fd, "# Size: %d\n", b->board_size);
+  fprintf(fd, "# Komi: %.1f\n", b->komi);
+  fprintf(fd, "# Host: %s\n", host);
+  fprintf(fd, "#GAME\tRES_B\tRES_W\tRES_R\tALT\tDUP\tLEN\tTIME_B\tTIME_W\tCPU_B\tCPU_W\tERR\tERR_MSG\n");
+  fprintf(fd, "0\t?\t?\t%s\t0\t-\t%d\t%.1f\t%.1f\t%.1f\t%.1f\t%d\t%s\n",
+	  res, result->moves, result->seconds[BLACK], result->seconds[WHITE],
+	  result->seconds[BLACK], result->seconds[WHITE],
+	  result->reason == 'F', result->message);
+  fclose(fd);
+
+  snprintf(path, sizeof(path), "%s-0.sgf", prefix);
+  fd = fopen(path, "w");
+  if (fd == NULL) {
+    perror(path);
+    return 0;
+  }
+  write_sgf(fd, b, black, white, moves, result);
+  fclose(fd);
+  return 1;
+}
@@ -0,0 +1,69 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * This is Evo, a simple go program.                             *
+ *                                                               *
+ * Copyright 2023 by Urban Hafner                                *
+ *           2003 and 2004 by Gunnar Farnebäck.                  *
+ *                                                               *
+ * Permission is hereby granted, free of charge, to any person   *
+ * obtaining a copy of this file gtp.c, to deal in the Software  *
+ * without restriction, including without limitation the rights  *
+ * to use, copy, modify, merge, publish, distribute, and/or      *
+ * sell copies of the Software, and to permit persons to whom    *
+ * the Software is furnished to do so, provided that the above   *
+ * copyright notice(s) and this permission notice appear in all  *
+ * copies of the Software and that both the above copyright      *
+ * notice(s) and this permission notice appear in supporting     *
+ * documentation.                                                *
+ *                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY     *
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE    *
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR       *
+ * PURPOSE AND NONINFRINGEMENT OF THIRD PARTY RIGHTS. IN NO      *
+ * EVENT SHALL THE COPYRIGHT HOLDER OR HOLDERS INCLUDED IN THIS  *
+ * NOTICE BE LIABLE FOR ANY CLAIM, OR ANY SPECIAL INDIRECT OR    *
+ * CONSEQUENTIAL DAMAGES, OR ANY DAMAGES WHATSOEVER RESULTING    *
+ * FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF    *
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT    *
+ * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS       *
+ * SOFTWARE.                                                     *
+ *                                                               *
+ * Except as contained in this notice, the name of a copyright   *
+ * holder shall not be used in advertising or otherwise to       *
+ * promote the sale, use or other dealings in this Software      *
+ * without prior written authorization of the copyright holder.  *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Games between two players, played from start to end in memory. */
+
+typedef struct game_result {
+  /* Area score after taking off dead stones, positive when white wins,
+   * see tromp_taylor_score().
+   */
+  float score;
+
+  /* Moves played, passes included. */
+  int moves;
+
+  /* Seconds spent choosing moves, indexed by WHITE and BLACK. */
+  double seconds[3];
+
+  /* The color that lost without the game being scored, or EMPTY. The
+   * reason is 'R' for a resignation, 'T' for running out of time and
+   * 'F' for a failure, such as an illegal move, which is described in
+   * message. The score is then 1 or -1 for the winner.
+   */
+  int loser;
+  char reason;
+  char message[128];
+} game_result;
+
+void play_game(board_t *b, player_t *black, player_t *white, int max_moves,
+	       int *moves, game_result *result);
+void format_result(float score, char *buf, size_t size);
+void game_result_string(const game_result *result, char *buf, size_t size);
+void write_sgf(FILE *fd, board_t *b, const char *black, const char *white,
+	       const int *moves, const game_result *result);
+void player_name(const char *path, char *name, size_t size);
+int write_game_files(const char *prefix, board_t *b, const char *black,
+		     const char *white, const int *moves,
+		     const game_result *result);
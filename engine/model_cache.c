@@ -0,0 +1 @@
+../lib/model_cache.c
\ No newline at end of file
@@ -0,0 +1 @@
+../lib/model_cache.h
\ No newline at end of file
@@ -0,0 +1 @@
+../lib/population.c
\ No newline at end of file
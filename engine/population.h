@@ -0,0 +1 @@
+../lib/population.h
\ No newline at end of file
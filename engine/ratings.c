@@ -0,0 +1,154 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * This is Evo, a simple go program.                             *
+ *                                                               *
+ * Copyright 2023 by Urban Hafner                                *
+ *           2003 and 2004 by Gunnar Farnebäck.                  *
+ *                                                               *
+ * Permission is hereby granted, free of charge, to any person   *
+ * obtaining a copy of this file gtp.c, to deal in the Software  *
+ * without restriction, including without limitation the rights  *
+ * to use, copy, modify, merge, publish, distribute, and/or      *
+ * sell copies of the Software, and to permit persons to whom    *
+ * the Software is furnished to do so, provided that the above   *
+ * copyright notice(s) and this permission notice appear in all  *
+ * copies of the Software and that both the above copyright      *
+ * notice(s) and this permission notice appear in supporting     *
+ * documentation.                                                *
+ *                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY     *
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE    *
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR       *
+ * PURPOSE AND NONINFRINGEMENT OF THIRD PARTY RIGHTS. IN NO      *
+ * EVENT SHALL THE COPYRIGHT HOLDER OR HOLDERS INCLUDED IN THIS  *
+ * NOTICE BE LIABLE FOR ANY CLAIM, OR ANY SPECIAL INDIRECT OR    *
+ * CONSEQUENTIAL DAMAGES, OR ANY DAMAGES WHATSOEVER RESULTING    *
+ * FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF    *
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT    *
+ * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS       *
+ * SOFTWARE.                                                     *
+ *                                                               *
+ * Except as contained in this notice, the name of a copyright   *
+ * holder shall not be used in advertising or otherwise to       *
+ * promote the sale, use or other dealings in this Software      *
+ * without prior written authorization of the copyright holder.  *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "glicko.h"
+#include "json.h"
+
+/* Glicko-2 ratings of the players of a generation, from the results in
+ * its journal.jsonl. Every game is rated as it was played, so the
+ * ratings are the same whenever they are computed, and a result cut
+ * off by a crash is left out. Byes are not games and are not rated.
+ *
+ * Prints one line per player, highest rating first:
+ *
+ *   name rating deviation volatility games
+ *
+ * ruby/run_generation.rb pairs players and picks parents by them when
+ * settings.json has "ratings": true.
+ */
+
+typedef struct rated {
+  const char *name;
+  glicko rating;
+} rated;
+
+static void
+usage(void)
+{
+  fprintf(stderr, "Usage: ratings [generation]\n");
+  exit(1);
+}
+
+static int
+find_player(rated *players, int num_players, const char *name)
+{
+  int k;
+
+  for (k = 0; k < num_players; k++)
+    if (!strcmp(players[k].name, name))
+      return k;
+  fprintf(stderr, "ratings: unknown player %s\n", name);
+  exit(1);
+}
+
+static int
+by_rating(const void *a, const void *b)
+{
+  double ra = ((const rated *)a)->rating.rating;
+  double rb = ((const rated *)b)->rating.rating;
+  return (ra < rb) - (ra > rb);
+}
+
+int
+main(int argc, char **argv)
+{
+  json_value *data, *list;
+  rated *players;
+  int num_players;
+  FILE *fd;
+  char *line = NULL;
+  size_t capacity = 0;
+  ssize_t length;
+  int k;
+
+  if (argc > 2 || (argc == 2 && chdir(argv[1])))
+    usage();
+
+  data = json_read_file("data.json");
+  list = data != NULL ? json_get(data, "players") : NULL;
+  if (list == NULL || list->type != JSON_OBJECT) {
+    fprintf(stderr, "ratings: no players in data.json\n");
+    exit(1);
+  }
+  num_players = list->count;
+  players = malloc(num_players * sizeof(rated));
+  for (k = 0; k < num_players; k++) {
+    players[k].name = list->keys[k];
+    glicko_init(&players[k].rating);
+  }
+
+  fd = fopen("journal.jsonl", "rb");
+  while (fd != NULL && (length = getline(&line, &capacity, fd)) > 0
+	 && line[length - 1] == '\n') {
+    json_value *entry = json_parse(line);
+    json_value *white, *winner;
+    int b, w;
+
+    if (entry == NULL) {
+      fprintf(stderr, "ratings: corrupt line in journal.jsonl\n");
+      exit(1);
+    }
+    white = json_get(entry, "white");
+    winner = json_get(entry, "winner");
+    if (white != NULL && white->type == JSON_STRING && winner != NULL) {
+      b = find_player(players, num_players,
+		      json_get(entry, "black")->string);
+      w = find_player(players, num_players, white->string);
+      if (b == find_player(players, num_players, winner->string))
+	glicko_update(&players[b].rating, &players[w].rating);
+      else
+	glicko_update(&players[w].rating, &players[b].rating);
+    }
+    json_free(entry);
+  }
+  if (fd != NULL)
+    fclose(fd);
+  free(line);
+
+  qsort(players, num_players, sizeof(rated), by_rating);
+  for (k = 0; k < num_players; k++)
+    printf("%s %.1f %.1f %.6f %d\n", players[k].name,
+	   players[k].rating.rating, players[k].rating.deviation,
+	   players[k].rating.volatility, players[k].rating.games);
+
+  free(players);
+  json_free(data);
+  return 0;
+}
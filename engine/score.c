@@ -0,0 +1,256 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * This is Evo, a simple go program.                             *
+ *                                                               *
+ * Copyright 2023 by Urban Hafner                                *
+ *           2003 and 2004 by Gunnar Farnebäck.                  *
+ *                                                               *
+ * Permission is hereby granted, free of charge, to any person   *
+ * obtaining a copy of this file gtp.c, to deal in the Software  *
+ * without restriction, including without limitation the rights  *
+ * to use, copy, modify, merge, publish, distribute, and/or      *
+ * sell copies of the Software, and to permit persons to whom    *
+ * the Software is furnished to do so, provided that the above   *
+ * copyright notice(s) and this permission notice appear in all  *
+ * copies of the Software and that both the above copyright      *
+ * notice(s) and this permission notice appear in supporting     *
+ * documentation.                                                *
+ *                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY     *
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE    *
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR       *
+ * PURPOSE AND NONINFRINGEMENT OF THIRD PARTY RIGHTS. IN NO      *
+ * EVENT SHALL THE COPYRIGHT HOLDER OR HOLDERS INCLUDED IN THIS  *
+ * NOTICE BE LIABLE FOR ANY CLAIM, OR ANY SPECIAL INDIRECT OR    *
+ * CONSEQUENTIAL DAMAGES, OR ANY DAMAGES WHATSOEVER RESULTING    *
+ * FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF    *
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT    *
+ * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS       *
+ * SOFTWARE.                                                     *
+ *                                                               *
+ * Except as contained in this notice, the name of a copyright   *
+ * holder shall not be used in advertising or otherwise to       *
+ * promote the sale, use or other dealings in this Software      *
+ * without prior written authorization of the copyright holder.  *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <stdlib.h>
+
+#include "brown.h"
+#include "score.h"
+
+/* Plies read ahead when looking for dead stones. */
+#define READING_DEPTH 8
+
+/* Strings with more liberties than this are taken to be safe when the
+ * attacker is to move.
+ */
+#define MAX_ATTACK_LIBERTIES 2
+
+static int defend(board_t *b, int si, int sj, int attacker, int depth);
+
+/* Whether the attacker, moving first, captures the string at (si, sj)
+ * within depth plies. The attacker only plays on the liberties of the
+ * string.
+ */
+static int
+attack(board_t *b, int si, int sj, int attacker, int depth)
+{
+  int libi[MAX_BOARD * MAX_BOARD];
+  int libj[MAX_BOARD * MAX_BOARD];
+  int num_liberties;
+  int k;
+
+  if (get_board(b, si, sj) == EMPTY)
+    return 1;
+  if (depth == 0)
+    return 0;
+
+  num_liberties = get_liberties(b, si, sj, libi, libj);
+  if (num_liberties > MAX_ATTACK_LIBERTIES)
+    return 0;
+
+  for (k = 0; k < num_liberties; k++) {
+    int captured;
+
+    if (!legal_move(b, libi[k], libj[k], attacker)
+	|| suicide(b, libi[k], libj[k], attacker))
+      continue;
+
+    play_move(b, libi[k], libj[k], attacker);
+    captured = !defend(b, si, sj, attacker, depth - 1);
+    unmake_move(b);
+    if (captured)
+      return 1;
+  }
+
+  return 0;
+}
+
+/* Try a move of the defender and see if the string at (si, sj)
+ * survives it. A pass is (-1, -1).
+ */
+static int
+defended_by(board_t *b, int si, int sj, int i, int j, int attacker,
+	    int depth)
+{
+  int defender = OTHER_COLOR(attacker);
+  int saved;
+
+  if (i != -1
+      && (!legal_move(b, i, j, defender) || suicide(b, i, j, defender)))
+    return 0;
+
+  play_move(b, i, j, defender);
+  saved = get_board(b, si, sj) != EMPTY
+    && !attack(b, si, sj, attacker, depth - 1);
+  unmake_move(b);
+
+  return saved;
+}
+
+/* Whether the defender, moving first, keeps the string at (si, sj)
+ * alive for depth plies. Strings which are not settled within the
+ * depth count as alive. The defender may pass, extend on a liberty or
+ * capture an adjacent string in atari.
+ */
+static int
+defend(board_t *b, int si, int sj, int attacker, int depth)
+{
+  int stonei[MAX_BOARD * MAX_BOARD];
+  int stonej[MAX_BOARD * MAX_BOARD];
+  int libi[MAX_BOARD * MAX_BOARD];
+  int libj[MAX_BOARD * MAX_BOARD];
+  int num_stones, num_liberties;
+  int k, m;
+
+  if (get_board(b, si, sj) == EMPTY)
+    return 0;
+  if (depth == 0)
+    return 1;
+
+  if (defended_by(b, si, sj, -1, -1, attacker, depth))
+    return 1;
+
+  num_liberties = get_liberties(b, si, sj, libi, libj);
+  for (k = 0; k < num_liberties; k++)
+    if (defended_by(b, si, sj, libi[k], libj[k], attacker, depth))
+      return 1;
+
+  num_stones = get_string(b, si, sj, stonei, stonej);
+  for (k = 0; k < num_stones; k++)
+    for (m = 0; m < 4; m++) {
+      int ai = stonei[k] + deltai[m];
+      int aj = stonej[k] + deltaj[m];
+
+      if (!on_board(b, ai, aj) || get_board(b, ai, aj) != attacker)
+	continue;
+      if (get_liberties(b, ai, aj, libi, libj) > 1)
+	continue;
+      if (defended_by(b, si, sj, libi[0], libj[0], attacker, depth))
+	return 1;
+    }
+
+  return 0;
+}
+
+/* Set dead[POS(b, i, j)] to 1 for the stones which are captured even
+ * if their owner moves first, and to 0 for all other points. Groups
+ * without two eyes but with enough liberties to outlast the reading
+ * depth are left alive.
+ */
+void
+find_dead_stones(board_t *b, int *dead)
+{
+  int seen[MAX_BOARD * MAX_BOARD];
+  int stonei[MAX_BOARD * MAX_BOARD];
+  int stonej[MAX_BOARD * MAX_BOARD];
+  int points = b->board_size * b->board_size;
+  int pos, k;
+
+  for (pos = 0; pos < points; pos++) {
+    dead[pos] = 0;
+    seen[pos] = 0;
+  }
+
+  for (pos = 0; pos < points; pos++) {
+    int i = I(b, pos);
+    int j = J(b, pos);
+    int color = get_board(b, i, j);
+    int num_stones, lost;
+
+    if (color == EMPTY || seen[pos])
+      continue;
+
+    lost = !defend(b, i, j, OTHER_COLOR(color), READING_DEPTH);
+    num_stones = get_string(b, i, j, stonei, stonej);
+    for (k = 0; k < num_stones; k++) {
+      seen[POS(b, stonei[k], stonej[k])] = 1;
+      dead[POS(b, stonei[k], stonej[k])] = lost;
+    }
+  }
+}
+
+/* Score by area: stones of a color plus the empty regions which only
+ * reach stones of that color, with the dead stones, if dead is not
+ * NULL, taken off the board first. The result includes komi and is
+ * positive when white wins.
+ */
+float
+tromp_taylor_score(board_t *b, const int *dead)
+{
+  int color[MAX_BOARD * MAX_BOARD];
+  int seen[MAX_BOARD * MAX_BOARD];
+  int queue[MAX_BOARD * MAX_BOARD];
+  int points = b->board_size * b->board_size;
+  float score = b->komi;
+  int pos, k;
+
+  for (pos = 0; pos < points; pos++) {
+    color[pos] = get_board(b, I(b, pos), J(b, pos));
+    if (dead != NULL && dead[pos])
+      color[pos] = EMPTY;
+    seen[pos] = 0;
+  }
+
+  for (pos = 0; pos < points; pos++) {
+    int head = 0, tail = 0;
+    int reached = 0;
+
+    if (color[pos] == WHITE)
+      score++;
+    else if (color[pos] == BLACK)
+      score--;
+    if (color[pos] != EMPTY || seen[pos])
+      continue;
+
+    /* Flood fill the empty region and note the colors around it. */
+    seen[pos] = 1;
+    queue[tail++] = pos;
+    while (head < tail) {
+      int i = I(b, queue[head]);
+      int j = J(b, queue[head]);
+      head++;
+      for (k = 0; k < 4; k++) {
+	int ai = i + deltai[k];
+	int aj = j + deltaj[k];
+	int apos = POS(b, ai, aj);
+
+	if (!on_board(b, ai, aj))
+	  continue;
+	if (color[apos] != EMPTY)
+	  reached |= 1 << color[apos];
+	else if (!seen[apos]) {
+	  seen[apos] = 1;
+	  queue[tail++] = apos;
+	}
+      }
+    }
+
+    if (reached == 1 << WHITE)
+      score += tail;
+    else if (reached == 1 << BLACK)
+      score -= tail;
+  }
+
+  return score;
+}
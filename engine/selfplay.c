@@ -0,0 +1,239 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * This is Evo, a simple go program.                             *
+ *                                                               *
+ * Copyright 2023 by Urban Hafner                                *
+ *           2003 and 2004 by Gunnar Farnebäck.                  *
+ *                                                               *
+ * Permission is hereby granted, free of charge, to any person   *
+ * obtaining a copy of this file gtp.c, to deal in the Software  *
+ * without restriction, including without limitation the rights  *
+ * to use, copy, modify, merge, publish, distribute, and/or      *
+ * sell copies of the Software, and to permit persons to whom    *
+ * the Software is furnished to do so, provided that the above   *
+ * copyright notice(s) and this permission notice appear in all  *
+ * copies of the Software and that both the above copyright      *
+ * notice(s) and this permission notice appear in supporting     *
+ * documentation.                                                *
+ *                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY     *
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE    *
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR       *
+ * PURPOSE AND NONINFRINGEMENT OF THIRD PARTY RIGHTS. IN NO      *
+ * EVENT SHALL THE COPYRIGHT HOLDER OR HOLDERS INCLUDED IN THIS  *
+ * NOTICE BE LIABLE FOR ANY CLAIM, OR ANY SPECIAL INDIRECT OR    *
+ * CONSEQUENTIAL DAMAGES, OR ANY DAMAGES WHATSOEVER RESULTING    *
+ * FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF    *
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT    *
+ * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS       *
+ * SOFTWARE.                                                     *
+ *                                                               *
+ * Except as contained in this notice, the name of a copyright   *
+ * holder shall not be used in advertising or otherwise to       *
+ * promote the sale, use or other dealings in this Software      *
+ * without prior written authorization of the copyright holder.  *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "brown.h"
+#include "boards.h"
+#include "generate_move.h"
+#include "match.h"
+#include "score.h"
+
+/* Self-play of many games at once. K games, set with --games, advance
+ * in lockstep, one ply at a time. In every ply the positions waiting
+ * for the same net are gathered and the net runs once on all of them
+ * with genann_run_batch(), instead of once per position.
+ *
+ * With N nets game g has net g % N as black and a different net as
+ * white, so K = N * (N - 1) games play every ordered pair once. With a
+ * single net it plays itself. --stats prints for every ply how many
+ * games were still running, how full the batches were and how fast the
+ * nets ran, which is what K should be chosen by.
+ */
+
+pcg32_random_t rng;
+
+static void
+usage(void)
+{
+  fprintf(stderr, "Usage: selfplay [--size n] [--komi k] [--games K] [--maxmoves n] [--stats] ann ...\n");
+  exit(1);
+}
+
+static double
+now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static genann *
+load_net(const char *path)
+{
+  genann *net;
+  FILE *fd = fopen(path, "rb");
+
+  if (fd == NULL) {
+    perror(path);
+    exit(1);
+  }
+  net = genann_binary_read(fd);
+  fclose(fd);
+  if (net == NULL)
+    exit(1);
+  return net;
+}
+
+int
+main(int argc, char **argv)
+{
+  int size = 9, games = 64, max_moves = 0, stats = 0;
+  float komi = 6.5;
+  int num_nets, first_net, outputs;
+  genann **nets;
+  int *black, *white, *batch_games, *moves;
+  double *batch_inputs, *batch_outputs, *predictions;
+  boards_t bs;
+  long evals = 0, runs = 0;
+  double start, net_time = 0, elapsed;
+  int k, n, ply;
+
+  pcg32_srandom(time(NULL), (intptr_t)&rng);
+
+  for (k = 1; k < argc && !strncmp(argv[k], "--", 2); k += 2) {
+    if (!strcmp(argv[k], "--stats")) {
+      stats = 1;
+      k--;
+      continue;
+    }
+    if (k + 1 >= argc)
+      usage();
+    if (!strcmp(argv[k], "--size"))
+      size = atoi(argv[k + 1]);
+    else if (!strcmp(argv[k], "--komi"))
+      komi = atof(argv[k + 1]);
+    else if (!strcmp(argv[k], "--games"))
+      games = atoi(argv[k + 1]);
+    else if (!strcmp(argv[k], "--maxmoves"))
+      max_moves = atoi(argv[k + 1]);
+    else
+      usage();
+  }
+  first_net = k;
+  num_nets = argc - first_net;
+  if (num_nets < 1 || games < 1 || size < MIN_BOARD || size > MAX_BOARD)
+    usage();
+
+  outputs = size * size + 1;
+  nets = malloc(num_nets * sizeof(genann *));
+  for (n = 0; n < num_nets; n++) {
+    nets[n] = load_net(argv[first_net + n]);
+    if (nets[n]->inputs != outputs || nets[n]->outputs != outputs) {
+      fprintf(stderr, "%s is not a net for %dx%d\n", argv[first_net + n], size, size);
+      exit(1);
+    }
+  }
+
+  init_boards(&bs, games, size, komi);
+  if (max_moves > 0)
+    bs.max_moves = max_moves;
+
+  black = malloc(games * sizeof(int));
+  white = malloc(games * sizeof(int));
+  for (k = 0; k < games; k++) {
+    black[k] = k % num_nets;
+    white[k] = num_nets == 1
+      ? 0 : (black[k] + 1 + (k / num_nets) % (num_nets - 1)) % num_nets;
+  }
+
+  batch_games = malloc(games * sizeof(int));
+  batch_inputs = malloc(games * outputs * sizeof(double));
+  batch_outputs = malloc(games * outputs * sizeof(double));
+  predictions = calloc(games * outputs, sizeof(double));
+  moves = malloc(games * sizeof(int));
+
+  if (stats)
+    fprintf(stderr, "%5s %6s %6s %9s %10s %12s\n",
+	    "ply", "games", "evals", "occupancy", "mean batch", "evals/s");
+
+  start = now();
+  for (ply = 0; boards_finished(&bs) < games; ply++) {
+    long ply_evals = 0;
+    int ply_runs = 0;
+    double ply_start;
+
+    legal_move_masks(&bs);
+    boards_inputs(&bs);
+
+    /* One batch per net with all positions it has to move in. */
+    ply_start = now();
+    for (n = 0; n < num_nets; n++) {
+      int count = 0;
+
+      for (k = 0; k < games; k++)
+	if (!bs.finished[k]
+	    && (bs.to_move[k] == BLACK ? black[k] : white[k]) == n) {
+	  memcpy(batch_inputs + count * outputs, bs.inputs + k * outputs,
+		 outputs * sizeof(double));
+	  batch_games[count++] = k;
+	}
+      if (count == 0)
+	continue;
+
+      genann_run_batch(nets[n], count, batch_inputs, batch_outputs);
+      for (k = 0; k < count; k++)
+	memcpy(predictions + batch_games[k] * outputs,
+	       batch_outputs + k * outputs, outputs * sizeof(double));
+      ply_evals += count;
+      ply_runs++;
+    }
+    net_time += now() - ply_start;
+
+    if (stats)
+      fprintf(stderr, "%5d %6d %6ld %8.1f%% %10.1f %12.0f\n",
+	      ply, games - boards_finished(&bs), ply_evals,
+	      100.0 * ply_evals / games, (double)ply_evals / ply_runs,
+	      ply_evals / (now() - ply_start));
+
+    select_moves(&bs, predictions, moves);
+    play_moves(&bs, moves);
+    evals += ply_evals;
+    runs += ply_runs;
+  }
+  elapsed = now() - start;
+
+  for (k = 0; k < games; k++) {
+    int dead[MAX_BOARD * MAX_BOARD];
+    char black_name[256], white_name[256], res[32];
+
+    find_dead_stones(&bs.boards[k], dead);
+    format_result(tromp_taylor_score(&bs.boards[k], dead), res, sizeof(res));
+    player_name(argv[first_net + black[k]], black_name, sizeof(black_name));
+    player_name(argv[first_net + white[k]], white_name, sizeof(white_name));
+    printf("%d\t%s\t%s\t%s\t%d\n", k, black_name, white_name, res, bs.moves[k]);
+  }
+
+  fprintf(stderr, "%d games, %d plies, %ld evals in %ld batches (%.1f per batch)\n",
+	  games, ply, evals, runs, (double)evals / runs);
+  fprintf(stderr, "%.2f s, %.1f games/s, %.0f evals/s, %.0f%% of the time in the nets\n",
+	  elapsed, games / elapsed, evals / elapsed, 100 * net_time / elapsed);
+
+  for (n = 0; n < num_nets; n++)
+    genann_free(nets[n]);
+  free(nets);
+  free(black);
+  free(white);
+  free(batch_games);
+  free(batch_inputs);
+  free(batch_outputs);
+  free(predictions);
+  free(moves);
+  free_boards(&bs);
+  return 0;
+}
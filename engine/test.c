@@ -23,11 +23,22 @@
  *
  */
 
+#include "brown.h"
+#include "boards.h"
 #include "genann.h"
+#include "generate_move.h"
+#include "conformance.h"
+#include "model_cache.h"
+#include "glicko.h"
+#include "json.h"
+#include "match.h"
+#include "score.h"
 #include "minctest.h"
 #include <stdio.h>
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 
 
 
@@ -247,6 +258,104 @@ void binary_persist() {
     genann_free(second);
 }
 
+void binary_reload() {
+    genann *first = genann_init(100, 2, 20, 10);
+    genann *second = genann_init(100, 2, 20, 10);
+    genann *other = genann_init(100, 2, 21, 10);
+
+    FILE *out = fopen("persist.bin", "wb");
+    genann_binary_write(first, out);
+    fclose(out);
+
+    /* Same topology, the weights are read in place. */
+    double *weights = second->weight;
+    FILE *in = fopen("persist.bin", "rb");
+    lok(genann_binary_read_into(second, in));
+    fclose(in);
+    lok(second->weight == weights);
+    lok(!memcmp(first->weight, second->weight, first->total_weights * sizeof(double)));
+
+    /* Another topology is left alone. */
+    double kept = other->weight[0];
+    in = fopen("persist.bin", "rb");
+    lequal(genann_binary_read_into(other, in), 0);
+    fclose(in);
+    lok(other->weight[0] == kept);
+
+    /* So is a net when the file is cut short. */
+    out = fopen("persist.bin", "wb");
+    genann_binary_write(first, out);
+    fclose(out);
+    lok(truncate("persist.bin", 1000) == 0);
+    second->weight[0] = 42;
+    in = fopen("persist.bin", "rb");
+    lequal(genann_binary_read_into(second, in), 0);
+    fclose(in);
+    lok(second->weight[0] == 42);
+
+    genann_free(first);
+    genann_free(second);
+    genann_free(other);
+}
+
+void layers() {
+    const int hidden[3] = {7, 3, 5};
+    genann *first = genann_init_layers(4, 3, hidden, 2);
+
+    lequal(first->hidden, 7);
+    lequal(first->total_weights, 5*7 + 8*3 + 4*5 + 6*2);
+    lequal(first->total_neurons, 4 + 7 + 3 + 5 + 2);
+
+    FILE *out = fopen("persist.txt", "w");
+    genann_write(first, out);
+    fclose(out);
+
+    FILE *in = fopen("persist.txt", "r");
+    genann *second = genann_read(in);
+    fclose(in);
+
+    out = fopen("persist.bin", "wb");
+    genann_binary_write(first, out);
+    fclose(out);
+
+    in = fopen("persist.bin", "rb");
+    genann *third = genann_binary_read(in);
+    fclose(in);
+
+    genann *fourth = genann_copy(first);
+
+    int i;
+    for (i = 0; i < 3; ++i) {
+        lequal(second->hidden_sizes[i], hidden[i]);
+        lequal(third->hidden_sizes[i], hidden[i]);
+        lequal(fourth->hidden_sizes[i], hidden[i]);
+    }
+    for (i = 0; i < first->total_weights; ++i) {
+        lok(first->weight[i] == second->weight[i]);
+        lok(first->weight[i] == third->weight[i]);
+    }
+
+    /* Backprop has to move the outputs towards the target with layers of different sizes. */
+    double input[2] = {.5, .2};
+    double output = 1;
+    const int backprop_hidden[2] = {4, 2};
+    genann *ann = genann_init_layers(2, 2, backprop_hidden, 1);
+
+    double first_try = *genann_run(ann, input);
+    for (i = 0; i < 10; ++i) {
+        genann_train(ann, input, &output, .5);
+    }
+    double second_try = *genann_run(ann, input);
+    lok(fabs(first_try - output) > fabs(second_try - output));
+
+    genann_free(first);
+    genann_free(second);
+    genann_free(third);
+    genann_free(fourth);
+    genann_free(ann);
+}
+
+
 void copy() {
     genann *first = genann_init(1000, 5, 50, 10);
 
@@ -280,6 +389,568 @@ void sigmoid() {
 }
 
 
+void conformance() {
+    conformance_result results[conformance_paths()];
+    int n, p;
+
+    for (n = 0; n < 50; ++n) {
+        genann *ann = conformance_random_ann(100, 3, 64, 100);
+        conformance_check(ann, 40, 0, results);
+        for (p = 0; p < conformance_paths(); ++p) {
+            lok(results[p].max_error < 1e-9);
+            lok(results[p].disagreement == 0);
+        }
+        genann_free(ann);
+    }
+
+    /* The topology of a 9x9 net. */
+    genann *ann = genann_init(82, 2, 810, 82);
+    conformance_check(ann, 10, 0, results);
+    for (p = 0; p < conformance_paths(); ++p) {
+        lok(results[p].max_error < 1e-9);
+        lok(results[p].disagreement == 0);
+    }
+    genann_free(ann);
+}
+
+
+void cache() {
+    const char *paths[3] = {"persist.0.bin", "persist.1.bin", "persist.2.bin"};
+    int i;
+
+    for (i = 0; i < 3; ++i) {
+        genann *ann = genann_init(10, 1, 10, 10);
+        FILE *out = fopen(paths[i], "wb");
+        genann_binary_write(ann, out);
+        fclose(out);
+        genann_free(ann);
+    }
+
+    genann *probe = genann_init(10, 1, 10, 10);
+    model_cache *cache = model_cache_create(2 * genann_size(probe));
+    genann_free(probe);
+
+    genann *a = model_cache_get(cache, paths[0]);
+    genann *b = model_cache_get(cache, paths[1]);
+    lok(a != NULL && b != NULL && a != b);
+    lok(model_cache_get(cache, "persist.missing.bin") == NULL);
+    model_cache_release(cache, a);
+    model_cache_release(cache, b);
+
+    /* Touch the first net, so the second one is the least recently used. */
+    lok(model_cache_get(cache, paths[0]) == a);
+    model_cache_release(cache, a);
+    genann *c = model_cache_get(cache, paths[2]);
+    model_cache_release(cache, c);
+
+    model_cache_counters counters = model_cache_get_counters(cache);
+    lequal((int)counters.hits, 1);
+    lequal((int)counters.misses, 4);
+    lequal((int)counters.evictions, 1);
+    lok(model_cache_get(cache, paths[0]) == a);
+    model_cache_release(cache, a);
+
+    /* A prefetched net is a hit. */
+    model_cache_prefetch(cache, paths[1]);
+    model_cache_drain(cache);
+    b = model_cache_get(cache, paths[1]);
+    lok(b != NULL);
+    model_cache_release(cache, b);
+
+    counters = model_cache_get_counters(cache);
+    lequal((int)counters.hits, 3);
+    lequal((int)counters.prefetches, 1);
+    lequal((int)counters.evictions, 2);
+    lok(counters.bytes <= 2 * (size_t)genann_size(b));
+
+    model_cache_free(cache);
+}
+
+void json() {
+    json_value *v = json_parse("{\"round\": 2, \"games\": [{\"black\": \"1.ann\", \"white\": null}], \"name\": \"a\\\"b\\u00e9\"}");
+    lok(v != NULL);
+    lfequal(json_get(v, "round")->number, 2);
+    lequal(json_get(v, "games")->count, 1);
+    lok(json_get(json_get(v, "games")->items[0], "white")->type == JSON_NULL);
+    lok(!strcmp(json_get(v, "name")->string, "a\"b\xc3\xa9"));
+    lok(json_get(v, "missing") == NULL);
+
+    /* Written and read back, with a replaced and an added member. */
+    json_set(v, "round", json_new_number(3));
+    json_set(v, "ratio", json_new_number(0.1));
+    lok(json_write_file("persist.json", v));
+    json_value *w = json_read_file("persist.json");
+    lok(w != NULL);
+    lequal(w->count, 4);
+    lfequal(json_get(w, "round")->number, 3);
+    lok(json_get(w, "ratio")->number == 0.1);
+    lok(!strcmp(w->keys[3], "ratio"));
+    lok(!strcmp(json_get(w, "name")->string, json_get(v, "name")->string));
+
+    /* One line per journal entry, the way JSON.generate writes it. */
+    char *line = NULL;
+    size_t line_size = 0;
+    FILE *mem = open_memstream(&line, &line_size);
+    json_write_line(mem, json_get(v, "games"));
+    fclose(mem);
+    lok(!strcmp(line, "[{\"black\":\"1.ann\",\"white\":null}]\n"));
+    free(line);
+
+    lok(json_parse("{\"a\": }") == NULL);
+    lok(json_parse("[1, 2] 3") == NULL);
+    json_free(v);
+    json_free(w);
+}
+
+void rating() {
+    glicko a, b;
+    glicko_init(&a);
+    glicko_init(&b);
+
+    /* Equal players move apart by the same amount. */
+    glicko_update(&a, &b);
+    lfequal(a.rating, 1662.311);
+    lfequal(b.rating, 1337.689);
+    lfequal(a.deviation, 290.319);
+    lequal(a.games, 1);
+
+    /* An uncertain player gains a lot from beating a well known one,
+     * which hardly moves. */
+    a.rating = 1500;
+    a.deviation = 200;
+    b.rating = 1400;
+    b.deviation = 30;
+    glicko_update(&a, &b);
+    lfequal(a.rating, 1563.564);
+    lfequal(a.deviation, 175.403);
+    lfequal(b.rating, 1398.144);
+    lfequal(b.deviation, 31.670);
+    lok(fabs(a.volatility - 0.06) < 0.0001);
+}
+
+void board() {
+    board_t b;
+    init_brown(&b);
+    set_board_size(&b, 5);
+
+    /* Black captures the white stone at (0, 1), which makes a ko. */
+    play_move(&b, 0, 0, BLACK);
+    play_move(&b, 0, 1, WHITE);
+    play_move(&b, 1, 1, BLACK);
+    play_move(&b, 1, 2, WHITE);
+    play_move(&b, 0, 3, WHITE);
+    lequal(get_board(&b, 0, 1), WHITE);
+    play_move(&b, 0, 2, BLACK);
+    lequal(get_board(&b, 0, 1), EMPTY);
+    lequal(legal_move(&b, 0, 1, WHITE), 0);
+    lequal(legal_move(&b, 0, 1, BLACK), 1);
+
+    /* Filling the ko is not suicide for black, it would be for white
+     * if it did not capture. */
+    lequal(suicide(&b, 0, 1, BLACK), 0);
+    lequal(suicide(&b, 0, 1, WHITE), 0);
+    play_move(&b, 4, 4, BLACK);
+    play_move(&b, 3, 3, WHITE);
+    play_move(&b, 4, 3, WHITE);
+    play_move(&b, 2, 4, WHITE);
+    lequal(suicide(&b, 3, 4, BLACK), 1);
+    lequal(suicide(&b, 3, 4, WHITE), 0);
+    play_move(&b, 3, 4, WHITE);
+    lequal(get_board(&b, 4, 4), EMPTY);
+
+    int stonei[MAX_BOARD * MAX_BOARD], stonej[MAX_BOARD * MAX_BOARD];
+    lequal(get_string(&b, 0, 0, stonei, stonej), 1);
+    lequal(get_string(&b, 3, 4, stonei, stonej), 4);
+
+    double inputs[25];
+    board_inputs(&b, BLACK, inputs);
+    lfequal(inputs[POS(&b, 0, 0)], 1.0);
+    lfequal(inputs[POS(&b, 3, 3)], -1.0);
+    lfequal(inputs[POS(&b, 2, 2)], 0.0);
+
+    /* The black stone at (0, 2) is in atari. */
+    compute_final_status(&b);
+    lequal(get_final_status(&b, 0, 0), ALIVE);
+    lequal(get_final_status(&b, 0, 2), DEAD);
+    lequal(get_final_status(&b, 1, 1), ALIVE);
+    lequal(get_final_status(&b, 3, 3), ALIVE);
+    lequal(get_final_status(&b, 4, 4), WHITE_TERRITORY);
+
+    /* A second board does not share any state with the first. */
+    board_t other;
+    init_brown(&other);
+    set_board_size(&other, 5);
+    lok(board_empty(&other));
+    lequal(legal_move(&other, 0, 1, WHITE), 1);
+    play_move(&other, 2, 2, WHITE);
+    lequal(get_board(&b, 2, 2), EMPTY);
+    free_brown(&other);
+
+    clear_board(&b);
+    lok(board_empty(&b));
+    free_brown(&b);
+}
+
+void strings() {
+    board_t b;
+    init_brown(&b);
+    set_board_size(&b, 5);
+
+    /* Two black strings joined by the stone at (1, 2). */
+    play_move(&b, 1, 0, BLACK);
+    play_move(&b, 1, 1, BLACK);
+    play_move(&b, 1, 3, BLACK);
+    play_move(&b, 1, 4, BLACK);
+    play_move(&b, 1, 2, BLACK);
+    int stonei[MAX_BOARD * MAX_BOARD], stonej[MAX_BOARD * MAX_BOARD];
+    lequal(get_string(&b, 1, 4, stonei, stonej), 5);
+
+    /* White fills every liberty but (0, 0). Both colors capture there. */
+    int j;
+    for (j = 1; j < 5; ++j)
+        play_move(&b, 0, j, WHITE);
+    for (j = 0; j < 5; ++j)
+        play_move(&b, 2, j, WHITE);
+    lequal(suicide(&b, 0, 0, BLACK), 0);
+    lequal(suicide(&b, 0, 0, WHITE), 0);
+
+    /* Capturing the row gives the white strings their liberties back. */
+    play_move(&b, 0, 0, WHITE);
+    lequal(get_board(&b, 1, 2), EMPTY);
+    lequal(suicide(&b, 1, 2, BLACK), 0);
+    lequal(suicide(&b, 1, 2, WHITE), 0);
+    lequal(get_string(&b, 0, 0, stonei, stonej), 5);
+    free_brown(&b);
+}
+
+void superko() {
+    board_t b;
+    init_brown(&b);
+    set_board_size(&b, 5);
+    uint64_t empty = board_hash(&b);
+
+    /* The hash only depends on the position and the color to move. */
+    play_move(&b, 0, 0, BLACK);
+    play_move(&b, 4, 4, WHITE);
+    play_move(&b, 2, 2, BLACK);
+    uint64_t first = board_hash(&b);
+    clear_board(&b);
+    lok(board_hash(&b) == empty);
+    play_move(&b, 2, 2, BLACK);
+    play_move(&b, 4, 4, WHITE);
+    play_move(&b, 0, 0, BLACK);
+    lok(board_hash(&b) == first);
+    play_move(&b, -1, -1, WHITE);
+    lok(board_hash(&b) != first);
+
+    /* After a ko capture and two passes the simple ko rule no longer
+     * applies, but retaking would repeat the position. */
+    clear_board(&b);
+    play_move(&b, 0, 0, BLACK);
+    play_move(&b, 0, 1, WHITE);
+    play_move(&b, 1, 1, BLACK);
+    play_move(&b, 1, 2, WHITE);
+    play_move(&b, 0, 3, WHITE);
+    play_move(&b, 0, 2, BLACK);
+    lequal(legal_move(&b, 0, 1, WHITE), 0);
+    play_move(&b, -1, -1, WHITE);
+    play_move(&b, -1, -1, BLACK);
+    lequal(legal_move(&b, 0, 1, WHITE), 0);
+    lequal(legal_move(&b, 3, 3, WHITE), 1);
+    free_brown(&b);
+}
+
+void score() {
+    board_t b;
+    init_brown(&b);
+    set_board_size(&b, 5);
+    b.komi = 0.5;
+
+    /* Empty points which reach no stones belong to nobody. */
+    lfequal(tromp_taylor_score(&b, NULL), 0.5);
+
+    /* A black wall on column 1 and a white wall on column 3, with
+     * column 2 reaching both. */
+    int i;
+    for (i = 0; i < 5; ++i) {
+        play_move(&b, i, 1, BLACK);
+        play_move(&b, i, 3, WHITE);
+    }
+    lfequal(tromp_taylor_score(&b, NULL), 0.5);
+
+    /* A white stone in atari in black's area spoils the territory,
+     * unless it is taken off as dead. */
+    play_move(&b, 0, 0, WHITE);
+    lfequal(tromp_taylor_score(&b, NULL), 6.5);
+    uint64_t hash = board_hash(&b);
+    int dead[MAX_BOARD * MAX_BOARD];
+    find_dead_stones(&b, dead);
+    lok(board_hash(&b) == hash);
+    lequal(dead[POS(&b, 0, 0)], 1);
+    lequal(dead[POS(&b, 0, 1)], 0);
+    lequal(dead[POS(&b, 0, 3)], 0);
+    lfequal(tromp_taylor_score(&b, dead), 0.5);
+    free_brown(&b);
+}
+
+void mask() {
+    board_t b;
+    init_brown(&b);
+    set_board_size(&b, 9);
+
+    /* The mask must agree with the point by point checks in random games. */
+    int game, move, i, j, k, disagreements = 0;
+    srand(7);
+    for (game = 0; game < 20; ++game) {
+        clear_board(&b);
+        int color = BLACK;
+        for (move = 0; move < 150; ++move) {
+            uint64_t moves[MOVE_MASK_WORDS];
+            legal_move_mask(&b, color, moves);
+            for (i = 0; i < b.board_size; ++i) {
+                for (j = 0; j < b.board_size; ++j) {
+                    int expected = legal_move(&b, i, j, color) && !suicide(&b, i, j, color);
+                    if (expected && suicide(&b, i, j, OTHER_COLOR(color))) {
+                        expected = 0;
+                        for (k = 0; k < 4; ++k)
+                            if (on_board(&b, i + deltai[k], j + deltaj[k])
+                                && get_board(&b, i + deltai[k], j + deltaj[k]) == OTHER_COLOR(color))
+                                expected = 1;
+                    }
+                    int pos = POS(&b, i, j);
+                    disagreements += expected != (int)((moves[pos >> 6] >> (pos & 63)) & 1);
+                }
+            }
+            i = rand() % b.board_size;
+            j = rand() % b.board_size;
+            if (legal_move(&b, i, j, color))
+                play_move(&b, i, j, color);
+            color = OTHER_COLOR(color);
+        }
+    }
+    lequal(disagreements, 0);
+    free_brown(&b);
+}
+
+
+/* Everything unmake_move() has to restore, as far as it can be seen
+ * from outside of the board. */
+typedef struct {
+    uint64_t hash;
+    int stones[81];
+    int libs[81][2];
+    uint64_t moves[2][MOVE_MASK_WORDS];
+} position;
+
+void look(board_t *b, position *p) {
+    int i, j;
+    memset(p, 0, sizeof(*p));
+    p->hash = board_hash(b);
+    for (i = 0; i < 9; ++i) {
+        for (j = 0; j < 9; ++j) {
+            p->stones[POS(b, i, j)] = get_board(b, i, j);
+            if (get_board(b, i, j) == EMPTY) {
+                p->libs[POS(b, i, j)][0] = suicide(b, i, j, WHITE);
+                p->libs[POS(b, i, j)][1] = suicide(b, i, j, BLACK);
+            }
+        }
+    }
+    legal_move_mask(b, WHITE, p->moves[0]);
+    legal_move_mask(b, BLACK, p->moves[1]);
+}
+
+void undo() {
+    board_t b;
+    init_brown(&b);
+    set_board_size(&b, 9);
+    lequal(unmake_move(&b), 0);
+
+    /* Every move can be taken back, and a whole game can be taken back
+     * to the empty board. */
+    static position before[200];
+    position after;
+    int game, move, i, j, differences = 0;
+    srand(11);
+    for (game = 0; game < 10; ++game) {
+        clear_board(&b);
+        int color = BLACK;
+        for (move = 0; move < 200; ++move) {
+            look(&b, &before[move]);
+            for (i = 0; i < 9; ++i) {
+                for (j = 0; j < 9; ++j) {
+                    if (!legal_move(&b, i, j, color))
+                        continue;
+                    play_move(&b, i, j, color);
+                    unmake_move(&b);
+                    look(&b, &after);
+                    differences += memcmp(&before[move], &after, sizeof(after)) != 0;
+                }
+            }
+            do {
+                i = rand() % 10 - 1;
+                j = i < 0 ? -1 : rand() % 9;
+            } while (!legal_move(&b, i, j, color));
+            play_move(&b, i, j, color);
+            color = OTHER_COLOR(color);
+        }
+        for (move = 199; move >= 0; --move) {
+            unmake_move(&b);
+            look(&b, &after);
+            differences += memcmp(&before[move], &after, sizeof(after)) != 0;
+        }
+        lok(board_empty(&b));
+    }
+    lequal(differences, 0);
+
+    /* Taking back moves in the middle of a game leaves the same board
+     * as playing only the moves which were kept. */
+    board_t replay;
+    init_brown(&replay);
+    set_board_size(&replay, 9);
+    static int kept_i[2000], kept_j[2000];
+    differences = 0;
+    for (game = 0; game < 20; ++game) {
+        int kept = 0;
+        clear_board(&b);
+        for (move = 0; move < 2000; ++move) {
+            int color = kept % 2 ? WHITE : BLACK;
+            if (kept > 0 && rand() % 3 == 0) {
+                unmake_move(&b);
+                kept--;
+                continue;
+            }
+            do {
+                i = rand() % 10 - 1;
+                j = i < 0 ? -1 : rand() % 9;
+            } while (!legal_move(&b, i, j, color));
+            play_move(&b, i, j, color);
+            kept_i[kept] = i;
+            kept_j[kept] = j;
+            kept++;
+        }
+        clear_board(&replay);
+        for (move = 0; move < kept; ++move)
+            play_move(&replay, kept_i[move], kept_j[move], move % 2 ? WHITE : BLACK);
+        look(&b, &before[0]);
+        look(&replay, &after);
+        differences += memcmp(&before[0], &after, sizeof(after)) != 0;
+    }
+    lequal(differences, 0);
+    free_brown(&replay);
+    free_brown(&b);
+}
+
+
+/* Network outputs which only depend on the game, the move and the
+ * point, so that lockstep and one by one games see the same. */
+double fake_output(int game, int move, int point) {
+    unsigned h = game * 7919u + move * 104729u + point * 1299709u;
+    h = (h ^ (h >> 15)) * 2654435761u;
+    return (h ^ (h >> 13)) / 4294967296.0;
+}
+
+void lockstep() {
+    const int count = 6, points = 81;
+    boards_t bs;
+    init_boards(&bs, count, 9, 7.5);
+    lequal(boards_finished(&bs), 0);
+
+    double *predictions = malloc(count * (points + 1) * sizeof(double));
+    int moves[6], game, move, p, differences = 0;
+    double single_inputs[82];
+    for (move = 0; boards_finished(&bs) < count; ++move) {
+        legal_move_masks(&bs);
+        boards_inputs(&bs);
+        for (game = 0; game < count; ++game) {
+            generate_ann_inputs(&bs.boards[game], bs.to_move[game], single_inputs);
+            differences += memcmp(single_inputs, bs.inputs + game * (points + 1), sizeof(single_inputs)) != 0;
+            for (p = 0; p <= points; ++p)
+                predictions[game * (points + 1) + p] = fake_output(game, move, p);
+        }
+        select_moves(&bs, predictions, moves);
+        play_moves(&bs, moves);
+    }
+    lequal(differences, 0);
+
+    /* The same games played one at a time. */
+    board_t b;
+    init_brown(&b);
+    b.komi = 7.5;
+    set_board_size(&b, 9);
+    for (game = 0; game < count; ++game) {
+        int color = BLACK, passes = 0, i, j;
+        clear_board(&b);
+        for (move = 0; passes < 2 && move < 3 * points; ++move) {
+            for (p = 0; p <= points; ++p)
+                predictions[p] = fake_output(game, move, p);
+            find_and_set_best_move(&b, &i, &j, color, predictions);
+            play_move(&b, i, j, color);
+            passes = i == -1 ? passes + 1 : 0;
+            color = OTHER_COLOR(color);
+        }
+        lequal(bs.moves[game], move);
+        lok(board_hash(&bs.boards[game]) == board_hash(&b));
+    }
+
+    free_brown(&b);
+    free(predictions);
+    free_boards(&bs);
+}
+
+void match() {
+    genann *nets[2] = {genann_init(26, 1, 10, 26), genann_init(26, 1, 10, 26)};
+    player_t black, white;
+    init_player(&black, &nets[0], 1);
+    init_player(&white, &nets[1], 1);
+    board_t b;
+    init_brown(&b);
+    set_board_size(&b, 5);
+    b.komi = 0.5;
+
+    int moves[75];
+    game_result result;
+    play_game(&b, &black, &white, 75, moves, &result);
+    lok(result.moves > 0 && result.moves <= 75);
+    uint64_t hash = board_hash(&b);
+
+    /* Replaying the moves ends in the same, equally scored position. */
+    board_t replay;
+    init_brown(&replay);
+    set_board_size(&replay, 5);
+    replay.komi = 0.5;
+    int m, dead[MAX_BOARD * MAX_BOARD];
+    for (m = 0; m < result.moves; ++m)
+        play_move(&replay, moves[m] == -1 ? -1 : I(&replay, moves[m]),
+                  moves[m] == -1 ? -1 : J(&replay, moves[m]), m % 2 ? WHITE : BLACK);
+    lok(board_hash(&replay) == hash);
+    find_dead_stones(&replay, dead);
+    lfequal(tromp_taylor_score(&replay, dead), result.score);
+
+    /* Nets have no randomness, a rematch repeats the game. */
+    game_result again;
+    play_game(&b, &black, &white, 75, moves, &again);
+    lequal(again.moves, result.moves);
+    lfequal(again.score, result.score);
+
+    char res[32];
+    format_result(-2.5, res, sizeof(res));
+    lok(!strcmp(res, "B+2.5"));
+
+    /* A game lost by time is no score. */
+    again.loser = BLACK;
+    again.reason = 'T';
+    game_result_string(&again, res, sizeof(res));
+    lok(!strcmp(res, "W+T"));
+
+    free_brown(&replay);
+    free_brown(&b);
+    free_player(&black);
+    free_player(&white);
+    genann_free(nets[0]);
+    genann_free(nets[1]);
+}
+
+
 int main(int argc, char *argv[])
 {
     printf("GENANN TEST SUITE\n");
@@ -292,8 +963,22 @@ int main(int argc, char *argv[])
     lrun("train xor", train_xor);
     lrun("persist", persist);
     lrun("binary_persist", binary_persist);
+    lrun("binary_reload", binary_reload);
+    lrun("layers", layers);
     lrun("copy", copy);
     lrun("sigmoid", sigmoid);
+    lrun("conformance", conformance);
+    lrun("cache", cache);
+    lrun("json", json);
+    lrun("rating", rating);
+    lrun("board", board);
+    lrun("strings", strings);
+    lrun("superko", superko);
+    lrun("score", score);
+    lrun("mask", mask);
+    lrun("undo", undo);
+    lrun("lockstep", lockstep);
+    lrun("match", match);
 
     lresults();
 
@@ -0,0 +1,692 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * This is Evo, a simple go program.                             *
+ *                                                               *
+ * Copyright 2023 by Urban Hafner                                *
+ *           2003 and 2004 by Gunnar Farnebäck.                  *
+ *                                                               *
+ * Permission is hereby granted, free of charge, to any person   *
+ * obtaining a copy of this file gtp.c, to deal in the Software  *
+ * without restriction, including without limitation the rights  *
+ * to use, copy, modify, merge, publish, distribute, and/or      *
+ * sell copies of the Software, and to permit persons to whom    *
+ * the Software is furnished to do so, provided that the above   *
+ * copyright notice(s) and this permission notice appear in all  *
+ * copies of the Software and that both the above copyright      *
+ * notice(s) and this permission notice appear in supporting     *
+ * documentation.                                                *
+ *                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY     *
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE    *
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR       *
+ * PURPOSE AND NONINFRINGEMENT OF THIRD PARTY RIGHTS. IN NO      *
+ * EVENT SHALL THE COPYRIGHT HOLDER OR HOLDERS INCLUDED IN THIS  *
+ * NOTICE BE LIABLE FOR ANY CLAIM, OR ANY SPECIAL INDIRECT OR    *
+ * CONSEQUENTIAL DAMAGES, OR ANY DAMAGES WHATSOEVER RESULTING    *
+ * FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF    *
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT    *
+ * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS       *
+ * SOFTWARE.                                                     *
+ *                                                               *
+ * Except as contained in this notice, the name of a copyright   *
+ * holder shall not be used in advertising or otherwise to       *
+ * promote the sale, use or other dealings in this Software      *
+ * without prior written authorization of the copyright holder.  *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "brown.h"
+#include "generate_move.h"
+#include "glicko.h"
+#include "json.h"
+#include "match.h"
+#include "model_cache.h"
+
+/* The Swiss tournament of a generation, which the game loop of
+ * ruby/run_generation.rb plays otherwise. It runs in the directory of
+ * the generation and picks up data.json where setup_tournament, or an
+ * interrupted run, left it. It then plays the rest of the current round
+ * and all further rounds on a fixed pool of threads.
+ *
+ * Pairings, byes, points and the ranking are the same as in Ruby, and so
+ * are data.json and journal.jsonl (see ruby/journal.rb). Every result is
+ * appended to the journal as one line, and data.json is only rewritten
+ * when a round starts. Games between nets are played in memory, with the
+ * nets shared by all threads through a model cache. Games with an
+ * external engine are run by engine/twogtp. Every game leaves a .dat
+ * file behind for stats and ranking.
+ *
+ * Every player also has a Glicko-2 rating, which is updated after every
+ * game and replayed from the whole journal on a restart. With "ratings"
+ * in settings.json players are paired by rating instead of score, the
+ * way ruby/run_generation.rb does with engine/ratings.
+ */
+
+#define KOMI 6.5
+#define JOURNAL "journal.jsonl"
+
+pcg32_random_t rng;
+
+typedef struct player {
+  char *name;
+  char *command;
+  int points;
+  int external;
+} player;
+
+typedef struct standing {
+  int player;
+  int score;
+} standing;
+
+/* White is -1 for a bye. */
+typedef struct pairing {
+  int black;
+  int white;
+} pairing;
+
+static json_value *data;
+static player *players;
+static int num_players;
+static standing *ranking;
+static glicko *ratings;
+static int use_ratings;
+static int round_number, rounds;
+
+/* Games of the current round. The first next_game have been handed
+ * out, unfinished ones are listed in data.json unless the journal has
+ * their result.
+ */
+static pairing *games;
+static int *finished;
+static int num_games, next_game, remaining;
+
+static int board_size, max_moves;
+static const char *game_length;
+static model_cache *cache;
+static FILE *journal;
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t changed = PTHREAD_COND_INITIALIZER;
+static int stop = 0;
+
+static void
+usage(void)
+{
+  fprintf(stderr, "Usage: tournament [--threads n] [--memory mb] settings.json\n");
+  exit(1);
+}
+
+static void
+fail(const char *message, const char *what)
+{
+  fprintf(stderr, "tournament: %s %s\n", message, what);
+  exit(1);
+}
+
+/* Settings are strings when typed in by setup_experiment.rb. */
+static int
+setting(json_value *settings, const char *key)
+{
+  json_value *value = json_get(settings, key);
+
+  if (value != NULL && value->type == JSON_NUMBER)
+    return (int)value->number;
+  if (value != NULL && value->type == JSON_STRING)
+    return atoi(value->string);
+  fail("missing setting", key);
+  return 0;
+}
+
+static int
+find_player(const char *name)
+{
+  int k;
+
+  for (k = 0; k < num_players; k++)
+    if (!strcmp(players[k].name, name))
+      return k;
+  fail("unknown player", name);
+  return -1;
+}
+
+static void
+load_data(void)
+{
+  json_value *value, *list;
+  int k;
+
+  data = json_read_file("data.json");
+  if (data == NULL)
+    fail("cannot read", "data.json");
+
+  list = json_get(data, "players");
+  if (list == NULL || list->type != JSON_OBJECT)
+    fail("no players in", "data.json");
+  num_players = list->count;
+  players = calloc(num_players, sizeof(player));
+  for (k = 0; k < num_players; k++) {
+    json_value *command = json_get(list->items[k], "command");
+    json_value *points = json_get(list->items[k], "points");
+    json_value *external = json_get(list->items[k], "external");
+    players[k].name = list->keys[k];
+    players[k].command = command != NULL ? command->string : NULL;
+    players[k].points = points != NULL ? (int)points->number : 1;
+    players[k].external = external != NULL && external->type == JSON_TRUE;
+  }
+
+  list = json_get(data, "ranking");
+  if (list == NULL || list->count != num_players)
+    fail("no complete ranking in", "data.json");
+  ratings = malloc(num_players * sizeof(glicko));
+  for (k = 0; k < num_players; k++)
+    glicko_init(&ratings[k]);
+
+  ranking = malloc(num_players * sizeof(standing));
+  for (k = 0; k < num_players; k++) {
+    ranking[k].player = find_player(json_get(list->items[k], "name")->string);
+    ranking[k].score = (int)json_get(list->items[k], "score")->number;
+  }
+
+  value = json_get(data, "round");
+  round_number = value != NULL ? (int)value->number : 0;
+
+  list = json_get(data, "games");
+  num_games = list != NULL ? list->count : 0;
+  games = malloc((num_players / 2 + 1) * sizeof(pairing));
+  finished = calloc(num_players / 2 + 1, sizeof(int));
+  for (k = 0; k < num_games; k++) {
+    json_value *white = json_get(list->items[k], "white");
+    games[k].black = find_player(json_get(list->items[k], "black")->string);
+    games[k].white = white == NULL || white->type != JSON_STRING
+      ? -1 : find_player(white->string);
+  }
+}
+
+static void
+save_data(void)
+{
+  json_value *list;
+  int k;
+
+  json_set(data, "round", json_new_number(round_number));
+
+  list = json_new(JSON_ARRAY);
+  for (k = 0; k < num_players; k++) {
+    json_value *entry = json_new(JSON_OBJECT);
+    json_set(entry, "name", json_new_string(players[ranking[k].player].name));
+    json_set(entry, "score", json_new_number(ranking[k].score));
+    json_append(list, entry);
+  }
+  json_set(data, "ranking", list);
+
+  list = json_new(JSON_ARRAY);
+  for (k = 0; k < num_games; k++) {
+    json_value *entry;
+    if (finished[k])
+      continue;
+    entry = json_new(JSON_OBJECT);
+    json_set(entry, "black", json_new_string(players[games[k].black].name));
+    json_set(entry, "white", games[k].white == -1
+	     ? json_new(JSON_NULL)
+	     : json_new_string(players[games[k].white].name));
+    json_append(list, entry);
+  }
+  json_set(data, "games", list);
+  json_set(data, "journal", json_new_number(ftell(journal)));
+
+  if (!json_write_file("data.json", data))
+    fail("cannot write", "data.json");
+}
+
+/* Highest score first, players with the same score in random order. */
+static void
+sort_ranking(void)
+{
+  int k, m;
+
+  for (k = 1; k < num_players; k++) {
+    standing s = ranking[k];
+    for (m = k; m > 0 && ranking[m - 1].score < s.score; m--)
+      ranking[m] = ranking[m - 1];
+    ranking[m] = s;
+  }
+
+  for (k = 0; k < num_players; k = m) {
+    int n;
+    for (m = k; m < num_players && ranking[m].score == ranking[k].score; m++)
+      ;
+    for (n = m - 1; n > k; n--) {
+      int swap = k + pcg32_boundedrand(n - k + 1);
+      standing s = ranking[n];
+      ranking[n] = ranking[swap];
+      ranking[swap] = s;
+    }
+  }
+}
+
+/* The players in the order of the ranking, or with ratings highest
+ * rating first and players with the same rating in random order.
+ */
+static void
+pairing_order(int *order)
+{
+  int k, m;
+
+  for (k = 0; k < num_players; k++)
+    order[k] = ranking[k].player;
+  if (!use_ratings)
+    return;
+
+  for (k = 1; k < num_players; k++) {
+    int p = order[k];
+    for (m = k; m > 0 && ratings[order[m - 1]].rating < ratings[p].rating; m--)
+      order[m] = order[m - 1];
+    order[m] = p;
+  }
+
+  for (k = 0; k < num_players; k = m) {
+    int n;
+    for (m = k; m < num_players
+	   && ratings[order[m]].rating == ratings[order[k]].rating; m++)
+      ;
+    for (n = m - 1; n > k; n--) {
+      int swap = k + pcg32_boundedrand(n - k + 1);
+      int p = order[n];
+      order[n] = order[swap];
+      order[swap] = p;
+    }
+  }
+}
+
+/* Neighbours in the pairing order play each other, with random colors. */
+static void
+games_from_ranking(void)
+{
+  int *order = malloc(num_players * sizeof(int));
+  int k;
+
+  pairing_order(order);
+  memset(finished, 0, (num_players / 2 + 1) * sizeof(int));
+  num_games = 0;
+  for (k = 0; k < num_players; k += 2) {
+    pairing *g = &games[num_games++];
+    if (k + 1 == num_players) {
+      g->black = order[k];
+      g->white = -1;
+    }
+    else if (pcg32_boundedrand(2)) {
+      g->black = order[k];
+      g->white = order[k + 1];
+    }
+    else {
+      g->black = order[k + 1];
+      g->white = order[k];
+    }
+  }
+  free(order);
+}
+
+/* Rate a game from the journal. Byes are not rated. */
+static void
+rate_result(json_value *entry)
+{
+  json_value *black = json_get(entry, "black");
+  json_value *white = json_get(entry, "white");
+  json_value *winner = json_get(entry, "winner");
+  int b, w;
+
+  if (black == NULL || black->type != JSON_STRING || white == NULL
+      || winner == NULL || winner->type != JSON_STRING)
+    fail("corrupt line in", JOURNAL);
+  if (white->type != JSON_STRING)
+    return;
+
+  b = find_player(black->string);
+  w = find_player(white->string);
+  if (find_player(winner->string) == b)
+    glicko_update(&ratings[b], &ratings[w]);
+  else
+    glicko_update(&ratings[w], &ratings[b]);
+}
+
+/* Apply a result from the journal to the game it finishes. */
+static void
+apply_result(json_value *entry)
+{
+  json_value *black = json_get(entry, "black");
+  json_value *white = json_get(entry, "white");
+  json_value *winner = json_get(entry, "winner");
+  json_value *points = json_get(entry, "points");
+  int b, w, k;
+
+  if (black == NULL || black->type != JSON_STRING || white == NULL
+      || winner == NULL || winner->type != JSON_STRING || points == NULL)
+    fail("corrupt line in", JOURNAL);
+  b = find_player(black->string);
+  w = white->type == JSON_STRING ? find_player(white->string) : -1;
+
+  for (k = 0; k < num_games; k++)
+    if (!finished[k] && games[k].black == b && games[k].white == w)
+      break;
+  if (k == num_games)
+    return;
+
+  finished[k] = 1;
+  w = find_player(winner->string);
+  for (k = 0; k < num_players; k++)
+    if (ranking[k].player == w)
+      ranking[k].score += (int)points->number;
+}
+
+/* Rate every game in the journal, apply the results which were
+ * appended after data.json was written, and open it for the results to
+ * come. A last line without a newline was cut short by a crash and is
+ * removed.
+ */
+static void
+replay_journal(void)
+{
+  json_value *journal_offset = json_get(data, "journal");
+  long offset = journal_offset != NULL ? (long)journal_offset->number : 0;
+  FILE *fd = fopen(JOURNAL, "rb");
+  char *line = NULL;
+  size_t capacity = 0;
+  ssize_t length;
+  long complete = 0;
+
+  if (fd != NULL) {
+    while ((length = getline(&line, &capacity, fd)) > 0) {
+      json_value *entry;
+      if (line[length - 1] != '\n') {
+	if (truncate(JOURNAL, complete))
+	  fail("cannot repair", JOURNAL);
+	break;
+      }
+      entry = json_parse(line);
+      if (entry == NULL)
+	fail("corrupt line in", JOURNAL);
+      rate_result(entry);
+      if (complete >= offset)
+	apply_result(entry);
+      json_free(entry);
+      complete += length;
+    }
+    free(line);
+    fclose(fd);
+  }
+
+  journal = fopen(JOURNAL, "a");
+  if (journal == NULL)
+    fail("cannot open", JOURNAL);
+  fseek(journal, 0, SEEK_END);
+  sort_ranking();
+}
+
+/* Append a result as one line, which goes out in a single write. */
+static void
+journal_result(int game, int winner, int points)
+{
+  json_value *entry = json_new(JSON_OBJECT);
+
+  json_set(entry, "round", json_new_number(round_number));
+  json_set(entry, "black", json_new_string(players[games[game].black].name));
+  json_set(entry, "white", games[game].white == -1
+	   ? json_new(JSON_NULL)
+	   : json_new_string(players[games[game].white].name));
+  json_set(entry, "winner", json_new_string(players[winner].name));
+  json_set(entry, "points", json_new_number(points));
+  json_write_line(journal, entry);
+  if (fflush(journal))
+    fail("cannot write", JOURNAL);
+  json_free(entry);
+}
+
+/* Skip the byes, which are not played, and games whose result was in
+ * the journal. Called with the lock held. Returns whether there is a
+ * game to hand out.
+ */
+static int
+game_available(void)
+{
+  while (next_game < num_games
+	 && (games[next_game].white == -1 || finished[next_game]))
+    next_game++;
+  return next_game < num_games;
+}
+
+/* Called with the lock held. */
+static void
+record_result(int game, int winner, int points)
+{
+  int k;
+
+  for (k = 0; k < num_players; k++)
+    if (ranking[k].player == winner)
+      ranking[k].score += points;
+  if (games[game].white != -1)
+    glicko_update(&ratings[winner], &ratings[winner == games[game].black
+					     ? games[game].white
+					     : games[game].black]);
+
+  finished[game] = 1;
+  remaining--;
+  journal_result(game, winner, points);
+
+  printf("\rPlaying ... Game: %d/%d Round: %d/%d ", num_games - remaining,
+	 num_games, round_number + 1, rounds);
+  fflush(stdout);
+}
+
+/* A game against an external engine, which engine/twogtp plays. Returns
+ * whether black won.
+ */
+static int
+play_external(pairing *g, const char *prefix)
+{
+  char command[4096];
+  char line[1024];
+  char result[64] = "";
+  FILE *fd;
+
+  snprintf(command, sizeof(command),
+	   "../twogtp --size %d --komi %.1f --maxmoves %d --time %s"
+	   " \"%s\" \"%s\" %s",
+	   board_size, KOMI, max_moves, game_length,
+	   players[g->black].command, players[g->white].command, prefix);
+  fd = popen(command, "r");
+  if (fd == NULL)
+    fail("cannot run", command);
+  while (fgets(line, sizeof(line), fd) != NULL)
+    sscanf(line, "%*s %63s", result);
+  if (pclose(fd) != 0 || result[0] == 0)
+    fail("no result from", command);
+
+  return result[0] == 'B';
+}
+
+/* A game between two nets, played on this thread. Returns whether
+ * black won.
+ */
+static int
+play_nets(pairing *g, const char *prefix, board_t *b, int *moves)
+{
+  genann *black_net = model_cache_get(cache, players[g->black].name);
+  genann *white_net = model_cache_get(cache, players[g->white].name);
+  char black_name[256], white_name[256];
+  player_t black, white;
+  game_result result;
+
+  if (black_net == NULL)
+    fail("cannot load", players[g->black].name);
+  if (white_net == NULL)
+    fail("cannot load", players[g->white].name);
+
+  init_player(&black, &black_net, 1);
+  init_player(&white, &white_net, 1);
+  play_game(b, &black, &white, max_moves, moves, &result);
+  free_player(&black);
+  free_player(&white);
+  model_cache_release(cache, black_net);
+  model_cache_release(cache, white_net);
+
+  player_name(players[g->black].name, black_name, sizeof(black_name));
+  player_name(players[g->white].name, white_name, sizeof(white_name));
+  if (!write_game_files(prefix, b, black_name, white_name, moves, &result))
+    exit(1);
+  return result.score < 0;
+}
+
+static void *
+worker(void *arg)
+{
+  board_t *b = malloc(sizeof(board_t));
+  int *moves = malloc(max_moves * sizeof(int));
+
+  init_brown(b);
+  set_board_size(b, board_size);
+  b->komi = KOMI;
+
+  pthread_mutex_lock(&lock);
+  for (;;) {
+    char black[256], white[256], prefix[600];
+    pairing g;
+    int game, black_won;
+
+    while (!stop && !game_available())
+      pthread_cond_wait(&changed, &lock);
+    if (stop)
+      break;
+    game = next_game++;
+    g = games[game];
+    player_name(players[g.black].name, black, sizeof(black));
+    player_name(players[g.white].name, white, sizeof(white));
+    snprintf(prefix, sizeof(prefix), "%sx%sR%d", black, white, round_number);
+    pthread_mutex_unlock(&lock);
+
+    if (players[g.black].external || players[g.white].external)
+      black_won = play_external(&g, prefix);
+    else
+      black_won = play_nets(&g, prefix, b, moves);
+
+    pthread_mutex_lock(&lock);
+    if (black_won)
+      record_result(game, g.black, players[g.white].points);
+    else
+      record_result(game, g.white, players[g.black].points);
+    pthread_cond_broadcast(&changed);
+  }
+  pthread_mutex_unlock(&lock);
+
+  free_brown(b);
+  free(b);
+  free(moves);
+  return NULL;
+}
+
+/* Play the games of the current round, which are set up in games. */
+static void
+play_round(void)
+{
+  int k;
+
+  pthread_mutex_lock(&lock);
+  remaining = 0;
+  for (k = 0; k < num_games; k++)
+    remaining += !finished[k];
+
+  /* Byes are won right away. */
+  for (k = 0; k < num_games; k++)
+    if (games[k].white == -1 && !finished[k])
+      record_result(k, games[k].black, 1);
+
+  /* Hand out the other games. */
+  next_game = 0;
+  pthread_cond_broadcast(&changed);
+  while (remaining > 0)
+    pthread_cond_wait(&changed, &lock);
+  pthread_mutex_unlock(&lock);
+}
+
+int
+main(int argc, char **argv)
+{
+  json_value *settings;
+  pthread_t *threads;
+  int num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+  size_t memory = 4096;
+  int k;
+
+  pcg32_srandom(time(NULL), (intptr_t)&rng);
+
+  for (k = 1; k < argc && !strncmp(argv[k], "--", 2); k += 2) {
+    if (k + 1 >= argc)
+      usage();
+    if (!strcmp(argv[k], "--threads"))
+      num_threads = atoi(argv[k + 1]);
+    else if (!strcmp(argv[k], "--memory"))
+      memory = atol(argv[k + 1]);
+    else
+      usage();
+  }
+  if (k + 1 != argc || num_threads < 1)
+    usage();
+
+  settings = json_read_file(argv[k]);
+  if (settings == NULL)
+    fail("cannot read", argv[k]);
+  board_size = setting(settings, "board_size");
+  max_moves = setting(settings, "max_moves");
+  rounds = setting(settings, "tournament_rounds");
+  game_length = json_get(settings, "game_length") != NULL
+    && json_get(settings, "game_length")->type == JSON_STRING
+    ? json_get(settings, "game_length")->string : "10";
+  use_ratings = json_get(settings, "ratings") != NULL
+    && json_get(settings, "ratings")->type == JSON_TRUE;
+  if (board_size < MIN_BOARD || board_size > MAX_BOARD || max_moves < 1)
+    fail("invalid settings in", argv[k]);
+
+  load_data();
+  replay_journal();
+  /* Nothing is handed out before play_round() counts the games. */
+  next_game = num_games;
+  cache = model_cache_create(memory << 20);
+
+  threads = malloc(num_threads * sizeof(pthread_t));
+  for (k = 0; k < num_threads; k++)
+    pthread_create(&threads[k], NULL, worker, NULL);
+
+  while (round_number < rounds) {
+    play_round();
+
+    pthread_mutex_lock(&lock);
+    round_number++;
+    sort_ranking();
+    if (round_number < rounds)
+      games_from_ranking();
+    else
+      num_games = 0;
+    next_game = num_games;
+    save_data();
+    pthread_mutex_unlock(&lock);
+  }
+  printf("\rPlaying ... done\n");
+
+  pthread_mutex_lock(&lock);
+  stop = 1;
+  pthread_cond_broadcast(&changed);
+  pthread_mutex_unlock(&lock);
+  for (k = 0; k < num_threads; k++)
+    pthread_join(threads[k], NULL);
+
+  model_cache_free(cache);
+  json_free(settings);
+  json_free(data);
+  fclose(journal);
+  return 0;
+}
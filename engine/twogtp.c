@@ -0,0 +1,573 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * This is Evo, a simple go program.                             *
+ *                                                               *
+ * Copyright 2023 by Urban Hafner                                *
+ *           2003 and 2004 by Gunnar Farnebäck.                  *
+ *                                                               *
+ * Permission is hereby granted, free of charge, to any person   *
+ * obtaining a copy of this file gtp.c, to deal in the Software  *
+ * without restriction, including without limitation the rights  *
+ * to use, copy, modify, merge, publish, distribute, and/or      *
+ * sell copies of the Software, and to permit persons to whom    *
+ * the Software is furnished to do so, provided that the above   *
+ * copyright notice(s) and this permission notice appear in all  *
+ * copies of the Software and that both the above copyright      *
+ * notice(s) and this permission notice appear in supporting     *
+ * documentation.                                                *
+ *                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY     *
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE    *
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR       *
+ * PURPOSE AND NONINFRINGEMENT OF THIRD PARTY RIGHTS. IN NO      *
+ * EVENT SHALL THE COPYRIGHT HOLDER OR HOLDERS INCLUDED IN THIS  *
+ * NOTICE BE LIABLE FOR ANY CLAIM, OR ANY SPECIAL INDIRECT OR    *
+ * CONSEQUENTIAL DAMAGES, OR ANY DAMAGES WHATSOEVER RESULTING    *
+ * FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF    *
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT    *
+ * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS       *
+ * SOFTWARE.                                                     *
+ *                                                               *
+ * Except as contained in this notice, the name of a copyright   *
+ * holder shall not be used in advertising or otherwise to       *
+ * promote the sale, use or other dealings in this Software      *
+ * without prior written authorization of the copyright holder.  *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/epoll.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "brown.h"
+#include "generate_move.h"
+#include "gtp.h"
+#include "match.h"
+#include "score.h"
+
+/* Games between GTP engines, the way gogui-twogtp plays them for the
+ * tournament, but many at once in one process and without a referee
+ * engine.
+ *
+ * Every game is given by three arguments: the command of black, the
+ * command of white and the prefix of its files. Up to --parallel games
+ * run at the same time, each with its own two engine processes, which
+ * are driven over pipes from a single epoll loop. A game ends after two
+ * passes in a row, a resignation or --maxmoves moves, and is scored by
+ * find_dead_stones() and tromp_taylor_score(). An engine loses when it
+ * uses up its --time for the game, plays an illegal move,
+ * rejects a legal one or stops answering. Every game is written as
+ * prefix.dat and prefix-0.sgf like arena writes them, and "prefix
+ * result" is printed when it is over.
+ */
+
+#define KOMI 6.5
+#define RESPONSE_SIZE 4096
+#define MAX_PENDING 8
+#define MAX_EVENTS 64
+
+pcg32_random_t rng;
+
+/* What a response answers. */
+enum { SETUP, OPTIONAL, NAME, GENMOVE, PLAY };
+
+typedef struct game game;
+
+typedef struct engine {
+  game *g;
+  int color;
+  pid_t pid;
+  int in, out;
+  char response[RESPONSE_SIZE];
+  int length;
+  int pending[MAX_PENDING];
+  int num_pending;
+  char name[64];
+} engine;
+
+struct game {
+  const char *commands[3];
+  const char *prefix;
+  engine engines[3];
+  board_t board;
+  int *moves;
+  game_result result;
+  int color;
+  int passes;
+  int setup;
+  double asked;
+  int running;
+};
+
+static int board_size = 9, max_moves = 0;
+static float komi = KOMI;
+static double time_limit = 0;
+static int epoll_fd;
+static int running = 0;
+
+/* A time like gogui-twogtp takes it, in minutes unless it ends in s or
+ * h. Byo-yomi after a + is ignored.
+ */
+static double
+parse_time(const char *s)
+{
+  char *end;
+  double t = strtod(s, &end);
+
+  if (*end == 's')
+    return t;
+  if (*end == 'h')
+    return t * 3600;
+  return t * 60;
+}
+
+static void
+usage(void)
+{
+  fprintf(stderr, "Usage: twogtp [--size n] [--komi k] [--maxmoves n] [--time t] [--parallel n] black white prefix ...\n");
+  exit(1);
+}
+
+static double
+now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* A vertex the way GTP writes it, skipping the letter I. */
+static void
+vertex(int i, int j, char *buf, size_t size)
+{
+  if (i == -1)
+    snprintf(buf, size, "pass");
+  else
+    snprintf(buf, size, "%c%d", 'A' + j + (j >= 8), board_size - i);
+}
+
+/* Run the command in a shell with pipes for GTP. Its stderr goes to
+ * /dev/null. Returns 0 on failure.
+ */
+static int
+start_engine(engine *e, const char *command)
+{
+  struct epoll_event event;
+  int to[2], from[2];
+
+  if (pipe2(to, O_CLOEXEC))
+    return 0;
+  if (pipe2(from, O_CLOEXEC)) {
+    close(to[0]);
+    close(to[1]);
+    return 0;
+  }
+
+  e->pid = fork();
+  if (e->pid == 0) {
+    FILE *null = fopen("/dev/null", "w");
+    setpgid(0, 0);
+    dup2(to[0], 0);
+    dup2(from[1], 1);
+    if (null != NULL)
+      dup2(fileno(null), 2);
+    execl("/bin/sh", "sh", "-c", command, (char *)NULL);
+    _exit(127);
+  }
+  close(to[0]);
+  close(from[1]);
+  e->in = to[1];
+  e->out = from[0];
+  if (e->pid < 0) {
+    close(e->in);
+    close(e->out);
+    e->in = e->out = -1;
+    return 0;
+  }
+
+  event.events = EPOLLIN;
+  event.data.ptr = e;
+  epoll_ctl(epoll_fd, EPOLL_CTL_ADD, e->out, &event);
+  return 1;
+}
+
+/* Ask the engine to quit, or kill its process group when it is out of
+ * time. It is reaped by the main loop.
+ */
+static void
+stop_engine(engine *e, int kill_it)
+{
+  if (e->out < 0)
+    return;
+  if (kill_it || write(e->in, "quit\n", 5) < 0)
+    kill(-e->pid, SIGKILL);
+  epoll_ctl(epoll_fd, EPOLL_CTL_DEL, e->out, NULL);
+  close(e->in);
+  close(e->out);
+  e->in = e->out = -1;
+}
+
+/* Send a command and remember what its response answers. Returns 0 if
+ * the engine is gone.
+ */
+static int
+send_command(engine *e, int kind, const char *format, ...)
+{
+  char line[256];
+  va_list ap;
+  int length, written = 0;
+
+  va_start(ap, format);
+  length = vsnprintf(line, sizeof(line) - 1, format, ap);
+  va_end(ap);
+  line[length++] = '\n';
+
+  if (e->in < 0 || e->num_pending == MAX_PENDING)
+    return 0;
+  while (written < length) {
+    ssize_t n = write(e->in, line + written, length - written);
+    if (n <= 0)
+      return 0;
+    written += n;
+  }
+  e->pending[e->num_pending++] = kind;
+  return 1;
+}
+
+/* Score the game, unless loser lost it some other way, write its files
+ * and stop its engines.
+ */
+static void
+end_game(game *g, int loser, char reason, const char *message)
+{
+  game_result *result = &g->result;
+  char black[64], white[64], res[32];
+  int dead[MAX_BOARD * MAX_BOARD];
+
+  if (!g->running)
+    return;
+  g->running = 0;
+  running--;
+
+  result->loser = loser;
+  result->reason = reason;
+  snprintf(result->message, sizeof(result->message), "%s", message);
+  if (loser == EMPTY) {
+    find_dead_stones(&g->board, dead);
+    result->score = tromp_taylor_score(&g->board, dead);
+  }
+  else
+    result->score = loser == BLACK ? 1 : -1;
+
+  stop_engine(&g->engines[BLACK], loser == BLACK && reason == 'T');
+  stop_engine(&g->engines[WHITE], loser == WHITE && reason == 'T');
+
+  snprintf(black, sizeof(black), "%s", g->engines[BLACK].name);
+  snprintf(white, sizeof(white), "%s", g->engines[WHITE].name);
+  if (!write_game_files(g->prefix, &g->board, black, white, g->moves, result))
+    exit(1);
+
+  game_result_string(result, res, sizeof(res));
+  printf("%s %s\n", g->prefix, res);
+  fflush(stdout);
+}
+
+static void
+ask_move(game *g)
+{
+  engine *e = &g->engines[g->color];
+
+  g->asked = now();
+  if (!send_command(e, GENMOVE, "genmove %c", g->color == BLACK ? 'b' : 'w'))
+    end_game(g, g->color, 'F', "engine exited");
+}
+
+static void
+start_game(game *g)
+{
+  int color;
+
+  init_brown(&g->board);
+  set_board_size(&g->board, board_size);
+  g->board.komi = komi;
+  g->moves = malloc(max_moves * sizeof(int));
+  memset(&g->result, 0, sizeof(g->result));
+  g->color = BLACK;
+  g->passes = 0;
+  g->setup = 0;
+  g->running = 1;
+  running++;
+
+  for (color = WHITE; color <= BLACK; color++) {
+    engine *e = &g->engines[color];
+    e->g = g;
+    e->color = color;
+    e->in = e->out = -1;
+    e->length = 0;
+    e->num_pending = 0;
+    snprintf(e->name, sizeof(e->name), "%s", g->commands[color]);
+  }
+
+  for (color = WHITE; color <= BLACK; color++) {
+    engine *e = &g->engines[color];
+    if (!start_engine(e, g->commands[color])
+	|| !send_command(e, NAME, "name")
+	|| !send_command(e, SETUP, "boardsize %d", board_size)
+	|| !send_command(e, SETUP, "clear_board")
+	|| !send_command(e, SETUP, "komi %.1f", komi)
+	|| (time_limit > 0
+	    && !send_command(e, OPTIONAL, "time_settings %d 0 0",
+			     (int)time_limit))) {
+      end_game(g, color, 'F', "cannot start engine");
+      return;
+    }
+    g->setup += e->num_pending;
+  }
+}
+
+/* The engine to move answered genmove. */
+static void
+play_answer(game *g, int success, char *text)
+{
+  engine *opponent = &g->engines[OTHER_COLOR(g->color)];
+  int color = g->color;
+  char buf[16];
+  int i = -1, j = -1;
+
+  g->result.seconds[color] += now() - g->asked;
+  if (time_limit > 0 && g->result.seconds[color] > time_limit) {
+    end_game(g, color, 'T', "");
+    return;
+  }
+  if (!success) {
+    end_game(g, color, 'F', "genmove failed");
+    return;
+  }
+  if (!strncasecmp(text, "resign", 6)) {
+    end_game(g, color, 'R', "");
+    return;
+  }
+  if (strncasecmp(text, "pass", 4)
+      && (!gtp_decode_coord(text, &i, &j)
+	  || !legal_move(&g->board, i, j, color))) {
+    end_game(g, color, 'F', "illegal move");
+    return;
+  }
+
+  play_move(&g->board, i, j, color);
+  g->moves[g->result.moves++] = i == -1 ? -1 : POS(&g->board, i, j);
+  g->passes = i == -1 ? g->passes + 1 : 0;
+  if (g->passes == 2 || g->result.moves == max_moves) {
+    end_game(g, EMPTY, 0, "");
+    return;
+  }
+
+  vertex(i, j, buf, sizeof(buf));
+  if (!send_command(opponent, PLAY, "play %c %s", color == BLACK ? 'b' : 'w', buf))
+    end_game(g, opponent->color, 'F', "engine exited");
+}
+
+static void
+handle_response(engine *e, int kind, int success, char *text)
+{
+  game *g = e->g;
+
+  switch (kind) {
+  case NAME:
+    if (success && *text)
+      snprintf(e->name, sizeof(e->name), "%.*s", (int)strcspn(text, "\n"), text);
+    break;
+  case SETUP:
+    if (!success) {
+      end_game(g, e->color, 'F', "setup failed");
+      return;
+    }
+    break;
+  case OPTIONAL:
+    break;
+  case GENMOVE:
+    play_answer(g, success, text);
+    return;
+  case PLAY:
+    if (!success) {
+      end_game(g, e->color, 'F', "rejected a legal move");
+      return;
+    }
+    g->color = OTHER_COLOR(g->color);
+    ask_move(g);
+    return;
+  }
+
+  if (--g->setup == 0)
+    ask_move(g);
+}
+
+/* Strip carriage returns, which some engines send. */
+static void
+strip_cr(engine *e, int from)
+{
+  int k, m;
+
+  for (k = m = from; k < e->length; k++)
+    if (e->response[k] != '\r')
+      e->response[m++] = e->response[k];
+  e->length = m;
+  e->response[m] = 0;
+}
+
+/* Read what the engine wrote and handle every complete response. */
+static void
+read_engine(engine *e)
+{
+  game *g = e->g;
+  ssize_t n;
+  char *end;
+
+  n = read(e->out, e->response + e->length, RESPONSE_SIZE - 1 - e->length);
+  if (n <= 0) {
+    end_game(g, e->color, 'F', "engine exited");
+    return;
+  }
+  e->length += n;
+  strip_cr(e, e->length - n);
+
+  while (g->running && (end = strstr(e->response, "\n\n")) != NULL) {
+    char *text = e->response + 1;
+    int success = e->response[0] == '=';
+    int kind, k;
+
+    *end = 0;
+    while (*text >= '0' && *text <= '9')
+      text++;
+    while (*text == ' ')
+      text++;
+    if (e->num_pending == 0 || (e->response[0] != '=' && e->response[0] != '?')) {
+      end_game(g, e->color, 'F', "unexpected response");
+      return;
+    }
+    kind = e->pending[0];
+    for (k = 1; k < e->num_pending; k++)
+      e->pending[k - 1] = e->pending[k];
+    e->num_pending--;
+
+    handle_response(e, kind, success, text);
+
+    if (e->out < 0)
+      return;
+    e->length -= end + 2 - e->response;
+    memmove(e->response, end + 2, e->length + 1);
+  }
+  if (g->running && e->length == RESPONSE_SIZE - 1)
+    end_game(g, e->color, 'F', "response too long");
+}
+
+/* Milliseconds until the first engine runs out of time, or -1. Engines
+ * already out of time lose.
+ */
+static int
+check_time(game *games, int num_games)
+{
+  double t = now(), first = -1;
+  int k;
+
+  if (time_limit <= 0)
+    return -1;
+  for (k = 0; k < num_games; k++) {
+    game *g = &games[k];
+    double left;
+    if (!g->running || g->setup > 0)
+      continue;
+    left = time_limit - g->result.seconds[g->color] - (t - g->asked);
+    if (left <= 0) {
+      g->result.seconds[g->color] = time_limit;
+      end_game(g, g->color, 'T', "");
+    }
+    else if (first < 0 || left < first)
+      first = left;
+  }
+  return first < 0 ? -1 : (int)(first * 1000) + 1;
+}
+
+int
+main(int argc, char **argv)
+{
+  struct epoll_event events[MAX_EVENTS];
+  game *games;
+  int parallel = 1, num_games, next = 0;
+  int k;
+
+  for (k = 1; k < argc && !strncmp(argv[k], "--", 2); k += 2) {
+    if (k + 1 == argc)
+      usage();
+    if (!strcmp(argv[k], "--size"))
+      board_size = atoi(argv[k + 1]);
+    else if (!strcmp(argv[k], "--komi"))
+      komi = atof(argv[k + 1]);
+    else if (!strcmp(argv[k], "--maxmoves"))
+      max_moves = atoi(argv[k + 1]);
+    else if (!strcmp(argv[k], "--time"))
+      time_limit = parse_time(argv[k + 1]);
+    else if (!strcmp(argv[k], "--parallel"))
+      parallel = atoi(argv[k + 1]);
+    else
+      usage();
+  }
+  if (k == argc || (argc - k) % 3 != 0 || board_size < 2
+      || board_size > MAX_BOARD || parallel < 1)
+    usage();
+  if (max_moves <= 0)
+    max_moves = 3 * board_size * board_size;
+
+  num_games = (argc - k) / 3;
+  games = calloc(num_games, sizeof(game));
+  for (next = 0; next < num_games; next++, k += 3) {
+    games[next].commands[BLACK] = argv[k];
+    games[next].commands[WHITE] = argv[k + 1];
+    games[next].prefix = argv[k + 2];
+  }
+
+  signal(SIGPIPE, SIG_IGN);
+  gtp_internal_set_boardsize(board_size);
+  epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  if (epoll_fd < 0) {
+    perror("epoll_create1");
+    exit(1);
+  }
+
+  next = 0;
+  while (next < num_games || running > 0) {
+    int timeout, n;
+
+    while (running < parallel && next < num_games)
+      start_game(&games[next++]);
+    if (running == 0)
+      continue;
+
+    timeout = check_time(games, num_games);
+    n = epoll_wait(epoll_fd, events, MAX_EVENTS, timeout);
+    for (k = 0; k < n; k++) {
+      engine *e = events[k].data.ptr;
+      if (e->out >= 0)
+	read_engine(e);
+    }
+    check_time(games, num_games);
+
+    while (waitpid(-1, NULL, WNOHANG) > 0)
+      ;
+  }
+
+  while (wait(NULL) > 0)
+    ;
+  for (k = 0; k < num_games; k++)
+    free(games[k].moves);
+  free(games);
+  return 0;
+}
@@ -72,9 +72,11 @@ void check_nns(genann **nns) {
     printf("nn1.hidden_layers = %d, nn2.hidden_layers = %d\n", nn1->hidden_layers, nn2->hidden_layers);
     failed = true;
   }
-  if (nn1->hidden != nn2->hidden) {
-    printf("nn1.hidden = %d, nn2.hidden = %d\n", nn1->hidden, nn2->hidden);
-    failed = true;
+  for (int h = 0; !failed && h < nn1->hidden_layers; h++) {
+    if (nn1->hidden_sizes[h] != nn2->hidden_sizes[h]) {
+      printf("layer %d: nn1.hidden = %d, nn2.hidden = %d\n", h, nn1->hidden_sizes[h], nn2->hidden_sizes[h]);
+      failed = true;
+    }
   }
 
   if (failed) {
@@ -24,6 +24,7 @@ SOFTWARE.
 
 */
 
+#include "conformance.h"
 #include "evolve.h"
 #include "minctest.h"
 
@@ -43,8 +44,32 @@ void test_cross_over() {
   lfequal(nn2->weight[3], child->weight[3]);
 }
 
+// Children are ranked with the optimized kernels, so they must agree with genann_run
+void test_child_conformance() {
+  genann *nn1 = genann_init(82, 2, 50, 82);
+  genann *nn2 = genann_init(82, 2, 50, 82);
+  genann *children[2] = {cross_over(nn1, nn2, nn1->total_weights / 2), mutate(nn1)};
+  conformance_result results[conformance_paths()];
+
+  for (int c = 0; c < 2; c++) {
+    conformance_check(children[c], 20, 0, results);
+    for (int p = 0; p < conformance_paths(); p++) {
+      lok(results[p].max_error < 1e-9);
+      lok(results[p].disagreement == 0);
+    }
+    genann_free(children[c]);
+  }
+  genann_free(nn1);
+  genann_free(nn2);
+}
+
 int main(int argc, char **argv) {
   printf("Evolve test suite\n");
 
   lrun("cross_over", test_cross_over);
+  lrun("conformance", test_child_conformance);
+
+  lresults();
+
+  return lfails != 0;
 }
@@ -0,0 +1,190 @@
+/*
+
+MIT License
+
+Copyright (c) 2023 Urban Hafner
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "conformance.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+enum { PATH_RUN, PATH_TILED, PATH_BATCH };
+
+/* Every inference path to hold against genann_run. The first one is the
+ * reference itself, so its timing is the baseline for the others. */
+static const struct conformance_path {
+    const char *name;
+    int kind;
+    int tile;
+    int batch;
+} paths[] = {
+    {"run",              PATH_RUN,   1,  1},
+    {"tiled 2",          PATH_TILED, 2,  1},
+    {"tiled 4",          PATH_TILED, 4,  1},
+    {"tiled 8",          PATH_TILED, 8,  1},
+    {"batch 8",          PATH_BATCH, 1,  8},
+    {"batch 8 tiled 4",  PATH_BATCH, 4,  8},
+    {"batch 32 tiled 4", PATH_BATCH, 4, 32},
+};
+
+#define PATHS ((int)(sizeof(paths) / sizeof(paths[0])))
+
+
+int conformance_paths(void) {
+    return PATHS;
+}
+
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+static int argmax(double const *v, int n) {
+    int best = 0, k;
+    for (k = 1; k < n; ++k) {
+        if (v[k] > v[best]) best = k;
+    }
+    return best;
+}
+
+
+static void run_path(genann *ann, struct conformance_path const *p, int positions,
+        double const *inputs, double *outputs) {
+    const genann_tuning saved = ann->tuning;
+    int b;
+
+    ann->tuning.tile = p->tile;
+    ann->tuning.batch = p->batch;
+
+    for (b = 0; b < positions; b += p->batch) {
+        double const *in = inputs + b * ann->inputs;
+        double *out = outputs + b * ann->outputs;
+        const int n = positions - b < p->batch ? positions - b : p->batch;
+
+        switch (p->kind) {
+            case PATH_RUN:
+                memcpy(out, genann_run(ann, in), sizeof(double) * ann->outputs);
+                break;
+            case PATH_TILED:
+                memcpy(out, genann_run_tiled(ann, in), sizeof(double) * ann->outputs);
+                break;
+            case PATH_BATCH:
+                genann_run_batch(ann, n, in, out);
+                break;
+        }
+    }
+
+    ann->tuning = saved;
+}
+
+
+void conformance_check(genann *ann, int positions, double seconds, conformance_result *results) {
+    double *inputs = malloc(sizeof(double) * positions * ann->inputs);
+    double *expected = malloc(sizeof(double) * positions * ann->outputs);
+    double *actual = malloc(sizeof(double) * positions * ann->outputs);
+    int p, b, k;
+
+    for (k = 0; k < positions * ann->inputs; ++k) {
+        inputs[k] = GENANN_RANDOM() * 2.0 - 1.0;
+    }
+
+    run_path(ann, &paths[0], positions, inputs, expected);
+
+    for (p = 0; p < PATHS; ++p) {
+        conformance_result *r = results + p;
+        int disagreements = 0;
+
+        run_path(ann, &paths[p], positions, inputs, actual);
+
+        r->name = paths[p].name;
+        r->max_error = 0;
+        for (b = 0; b < positions; ++b) {
+            double const *e = expected + b * ann->outputs;
+            double const *a = actual + b * ann->outputs;
+            for (k = 0; k < ann->outputs; ++k) {
+                const double error = fabs(e[k] - a[k]);
+                if (error > r->max_error) r->max_error = error;
+            }
+            if (argmax(e, ann->outputs) != argmax(a, ann->outputs)) ++disagreements;
+        }
+        r->disagreement = (double)disagreements / positions;
+
+        r->ns_per_weight = 0;
+        r->gb_per_s = 0;
+        if (seconds > 0) {
+            long passes = 0;
+            const double start = now();
+            double elapsed;
+            do {
+                run_path(ann, &paths[p], positions, inputs, actual);
+                ++passes;
+                elapsed = now() - start;
+            } while (elapsed < seconds);
+
+            const double weights = (double)passes * positions * ann->total_weights;
+            r->ns_per_weight = elapsed * 1e9 / weights;
+            r->gb_per_s = weights * sizeof(double) / elapsed * 1e-9;
+        }
+    }
+
+    free(inputs);
+    free(expected);
+    free(actual);
+}
+
+
+genann *conformance_random_ann(int max_inputs, int max_hidden_layers, int max_hidden, int max_outputs) {
+    const int inputs = 1 + pcg32_boundedrand(max_inputs);
+    const int hidden_layers = pcg32_boundedrand(max_hidden_layers + 1);
+    const int outputs = 1 + pcg32_boundedrand(max_outputs);
+    int hidden[max_hidden_layers + 1];
+    int h;
+
+    for (h = 0; h < hidden_layers; ++h) {
+        hidden[h] = 1 + pcg32_boundedrand(max_hidden);
+    }
+
+    return genann_init_layers(inputs, hidden_layers, hidden, outputs);
+}
+
+
+void conformance_print(FILE *out, genann const *ann, conformance_result const *results) {
+    int p, h;
+
+    fprintf(out, "%d inputs, %d layers (", ann->inputs, ann->hidden_layers);
+    for (h = 0; h < ann->hidden_layers; ++h) {
+        fprintf(out, h ? " %d" : "%d", ann->hidden_sizes[h]);
+    }
+    fprintf(out, " neurons), %d outputs\n", ann->outputs);
+    for (p = 0; p < PATHS; ++p) {
+        fprintf(out, "  %-18s max error %.3e  disagreement %5.1f%%  %7.3f ns/weight  %6.2f GB/s\n",
+                results[p].name, results[p].max_error, results[p].disagreement * 100,
+                results[p].ns_per_weight, results[p].gb_per_s);
+    }
+}
@@ -0,0 +1,69 @@
+/*
+
+MIT License
+
+Copyright (c) 2023 Urban Hafner
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#ifndef CONFORMANCE_H
+#define CONFORMANCE_H
+
+#include "genann.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* How one inference path compares to the scalar genann_run. */
+typedef struct conformance_result {
+    const char *name;
+
+    /* Largest absolute difference of any output to genann_run. */
+    double max_error;
+
+    /* Fraction of positions where the best output (the move) differs. */
+    double disagreement;
+
+    /* Time per weight and position, and the matching weight bandwidth. */
+    double ns_per_weight;
+    double gb_per_s;
+} conformance_result;
+
+/* Number of results filled in by conformance_check. */
+int conformance_paths(void);
+
+/* Runs positions random inputs through genann_run and every optimized path
+ * of ann. If seconds > 0 each path is also timed for about that long. */
+void conformance_check(genann *ann, int positions, double seconds, conformance_result *results);
+
+/* Creates a net with a random topology no larger than the given bounds.
+ * Every hidden layer gets its own size. */
+genann *conformance_random_ann(int max_inputs, int max_hidden_layers, int max_hidden, int max_outputs);
+
+/* Prints the results as a table, one line per path. */
+void conformance_print(FILE *out, genann const *ann, conformance_result const *results);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*CONFORMANCE_H*/
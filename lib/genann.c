@@ -106,26 +106,47 @@ double genann_act_threshold(const struct genann *ann unused, double a) {
 }
 
 genann *genann_init(int inputs, int hidden_layers, int hidden, int outputs) {
+    if (hidden_layers < 0) return 0;
+    if (hidden_layers > 0 && hidden < 1) return 0;
+
+    int sizes[hidden_layers + 1];
+    int h;
+    for (h = 0; h < hidden_layers; ++h) {
+        sizes[h] = hidden;
+    }
+
+    return genann_init_layers(inputs, hidden_layers, sizes, outputs);
+}
+
+
+genann *genann_init_layers(int inputs, int hidden_layers, int const *hidden, int outputs) {
     if (hidden_layers < 0) return 0;
     if (inputs < 1) return 0;
     if (outputs < 1) return 0;
-    if (hidden_layers > 0 && hidden < 1) return 0;
 
+    int h, widest = 0, hidden_neurons = 0, hidden_weights = 0, previous = inputs;
+    for (h = 0; h < hidden_layers; ++h) {
+        if (hidden[h] < 1) return 0;
+        if (hidden[h] > widest) widest = hidden[h];
+        hidden_neurons += hidden[h];
+        hidden_weights += (previous+1) * hidden[h];
+        previous = hidden[h];
+    }
 
-    const int hidden_weights = hidden_layers ? (inputs+1) * hidden + (hidden_layers-1) * (hidden+1) * hidden : 0;
-    const int output_weights = (hidden_layers ? (hidden+1) : (inputs+1)) * outputs;
+    const int output_weights = (previous+1) * outputs;
     const int total_weights = (hidden_weights + output_weights);
 
-    const int total_neurons = (inputs + hidden * hidden_layers + outputs);
+    const int total_neurons = (inputs + hidden_neurons + outputs);
 
-    /* Allocate extra size for weights, outputs, and deltas. */
-    const int size = sizeof(genann) + sizeof(double) * (total_weights + total_neurons + (total_neurons - inputs));
+    /* Allocate extra size for weights, outputs, deltas, and layer sizes. */
+    const int size = sizeof(genann) + sizeof(double) * (total_weights + total_neurons + (total_neurons - inputs))
+        + sizeof(int) * hidden_layers;
     genann *ret = malloc(size);
     if (!ret) return 0;
 
     ret->inputs = inputs;
     ret->hidden_layers = hidden_layers;
-    ret->hidden = hidden;
+    ret->hidden = widest;
     ret->outputs = outputs;
 
     ret->total_weights = total_weights;
@@ -135,21 +156,39 @@ genann *genann_init(int inputs, int hidden_layers, int hidden, int outputs) {
     ret->weight = (double*)((char*)ret + sizeof(genann));
     ret->output = ret->weight + ret->total_weights;
     ret->delta = ret->output + ret->total_neurons;
+    ret->hidden_sizes = (int*)(ret->delta + (ret->total_neurons - ret->inputs));
+
+    memcpy(ret->hidden_sizes, hidden, sizeof(int) * hidden_layers);
 
     genann_randomize(ret);
 
     ret->activation_hidden = genann_act_sigmoid_cached;
     ret->activation_output = genann_act_sigmoid_cached;
 
+    ret->tuning.tile = 1;
+    ret->tuning.batch = 1;
+
     genann_init_sigmoid_lookup(ret);
 
     return ret;
 }
 
 
+/* Do all hidden layers have the same size? Those nets are saved in the
+ * original format, everything else writes -1 as hidden and lists the
+ * sizes after the number of outputs. */
+static int genann_uniform(genann const *ann) {
+    int h;
+    for (h = 1; h < ann->hidden_layers; ++h) {
+        if (ann->hidden_sizes[h] != ann->hidden_sizes[0]) return 0;
+    }
+    return 1;
+}
+
+
 genann *genann_read(FILE *in) {
     int inputs, hidden_layers, hidden, outputs;
-    int rc;
+    int rc, h;
 
     errno = 0;
     rc = fscanf(in, "%d %d %d %d", &inputs, &hidden_layers, &hidden, &outputs);
@@ -157,8 +196,27 @@ genann *genann_read(FILE *in) {
         perror("fscanf");
         return NULL;
     }
+    if (hidden_layers < 0) return NULL;
+
+    int *sizes = malloc(sizeof(int) * (hidden_layers + 1));
+    if (!sizes) return NULL;
+    for (h = 0; h < hidden_layers; ++h) {
+        if (hidden >= 0) {
+            sizes[h] = hidden;
+            continue;
+        }
+        errno = 0;
+        rc = fscanf(in, " %d", sizes + h);
+        if (rc < 1 || errno != 0) {
+            perror("fscanf");
+            free(sizes);
+            return NULL;
+        }
+    }
 
-    genann *ann = genann_init(inputs, hidden_layers, hidden, outputs);
+    genann *ann = genann_init_layers(inputs, hidden_layers, sizes, outputs);
+    free(sizes);
+    if (!ann) return NULL;
 
     int i;
     for (i = 0; i < ann->total_weights; ++i) {
@@ -184,8 +242,27 @@ genann *genann_binary_read(FILE *in) {
         perror("fread");
         return NULL;
     }
+    if (config[1] < 0) return NULL;
+
+    int *sizes = malloc(sizeof(int) * (config[1] + 1));
+    if (!sizes) return NULL;
+    if (config[2] >= 0) {
+        int h;
+        for (h = 0; h < config[1]; ++h) {
+            sizes[h] = config[2];
+        }
+    } else {
+        rc = fread(sizes, sizeof(int), config[1], in);
+        if (rc < config[1]) {
+            perror("fread");
+            free(sizes);
+            return NULL;
+        }
+    }
 
-    genann *ann = genann_init(config[0], config[1], config[2], config[3]);
+    genann *ann = genann_init_layers(config[0], config[1], sizes, config[3]);
+    free(sizes);
+    if (!ann) return NULL;
 
     int i;
     for (i = 0; i < ann->total_weights; ++i) {
@@ -202,8 +279,38 @@ genann *genann_binary_read(FILE *in) {
 }
 
 
+int genann_binary_read_into(genann *ann, FILE *in) {
+    int config[4];
+    int h;
+
+    if (fread(config, sizeof(int), 4, in) < 4) return 0;
+    if (config[0] != ann->inputs || config[1] != ann->hidden_layers || config[3] != ann->outputs) return 0;
+
+    for (h = 0; h < ann->hidden_layers; ++h) {
+        int size = config[2];
+        if (config[2] < 0 && fread(&size, sizeof(int), 1, in) < 1) return 0;
+        if (size != ann->hidden_sizes[h]) return 0;
+    }
+
+    /* Only overwrite the weights if all of them are there. */
+    long start = ftell(in);
+    if (start < 0 || fseek(in, 0, SEEK_END)) return 0;
+    long end = ftell(in);
+    if (fseek(in, start, SEEK_SET)) return 0;
+    if (end - start != (long)(sizeof(double) * ann->total_weights)) return 0;
+
+    return fread(ann->weight, sizeof(double), ann->total_weights, in) == (size_t)ann->total_weights;
+}
+
+
+int genann_size(genann const *ann) {
+    return sizeof(genann) + sizeof(double) * (ann->total_weights + ann->total_neurons + (ann->total_neurons - ann->inputs))
+        + sizeof(int) * ann->hidden_layers;
+}
+
+
 genann *genann_copy(genann const *ann) {
-    const int size = sizeof(genann) + sizeof(double) * (ann->total_weights + ann->total_neurons + (ann->total_neurons - ann->inputs));
+    const int size = genann_size(ann);
     genann *ret = malloc(size);
     if (!ret) return 0;
 
@@ -213,6 +320,7 @@ genann *genann_copy(genann const *ann) {
     ret->weight = (double*)((char*)ret + sizeof(genann));
     ret->output = ret->weight + ret->total_weights;
     ret->delta = ret->output + ret->total_neurons;
+    ret->hidden_sizes = (int*)(ret->delta + (ret->total_neurons - ret->inputs));
 
     return ret;
 }
@@ -238,6 +346,7 @@ double const *genann_run(genann const *ann, double const *inputs) {
     double const *w = ann->weight;
     double *o = ann->output + ann->inputs;
     double const *i = ann->output;
+    int n_in = ann->inputs;
 
     /* Copy the inputs to the scratch area, where we also store each neuron's
      * output, for consistency. This way the first layer isn't a special case. */
@@ -245,41 +354,18 @@ double const *genann_run(genann const *ann, double const *inputs) {
 
     int h, j, k;
 
-    if (!ann->hidden_layers) {
-        double *ret = o;
-        for (j = 0; j < ann->outputs; ++j) {
-            double sum = *w++ * -1.0;
-            for (k = 0; k < ann->inputs; ++k) {
-                sum += *w++ * i[k];
-            }
-            *o++ = genann_act_output(ann, sum);
-        }
-
-        return ret;
-    }
-
-    /* Figure input layer */
-    for (j = 0; j < ann->hidden; ++j) {
-        double sum = *w++ * -1.0;
-        for (k = 0; k < ann->inputs; ++k) {
-            sum += *w++ * i[k];
-        }
-        *o++ = genann_act_hidden(ann, sum);
-    }
-
-    i += ann->inputs;
-
     /* Figure hidden layers, if any. */
-    for (h = 1; h < ann->hidden_layers; ++h) {
-        for (j = 0; j < ann->hidden; ++j) {
+    for (h = 0; h < ann->hidden_layers; ++h) {
+        for (j = 0; j < ann->hidden_sizes[h]; ++j) {
             double sum = *w++ * -1.0;
-            for (k = 0; k < ann->hidden; ++k) {
+            for (k = 0; k < n_in; ++k) {
                 sum += *w++ * i[k];
             }
             *o++ = genann_act_hidden(ann, sum);
         }
 
-        i += ann->hidden;
+        i += n_in;
+        n_in = ann->hidden_sizes[h];
     }
 
     double const *ret = o;
@@ -287,7 +373,7 @@ double const *genann_run(genann const *ann, double const *inputs) {
     /* Figure output layer. */
     for (j = 0; j < ann->outputs; ++j) {
         double sum = *w++ * -1.0;
-        for (k = 0; k < ann->hidden; ++k) {
+        for (k = 0; k < n_in; ++k) {
             sum += *w++ * i[k];
         }
         *o++ = genann_act_output(ann, sum);
@@ -301,16 +387,133 @@ double const *genann_run(genann const *ann, double const *inputs) {
 }
 
 
+/* Computes one layer for n positions. Each input row is n_in long and each
+ * output row n_out long. Neurons are handled tile at a time, so every input
+ * value loaded is used for tile weight rows while they are in cache. Each
+ * neuron still sums its inputs in the same order as genann_run does. */
+static inline void genann_layer(genann const *ann, int output_layer, double const *w,
+        int n_in, int n_out, int n, double const *in, double *out, const int tile) {
+    const int row = n_in + 1;
+    int j = 0, b, k, t;
+
+    for (; j + tile <= n_out; j += tile) {
+        double const *wt = w + j * row;
+        for (b = 0; b < n; ++b) {
+            double const *x = in + b * n_in;
+            double sum[8];
+            for (t = 0; t < tile; ++t) sum[t] = wt[t * row] * -1.0;
+            for (k = 0; k < n_in; ++k) {
+                const double xk = x[k];
+                for (t = 0; t < tile; ++t) sum[t] += wt[t * row + k + 1] * xk;
+            }
+            for (t = 0; t < tile; ++t) {
+                out[b * n_out + j + t] = output_layer
+                    ? genann_act_output(ann, sum[t])
+                    : genann_act_hidden(ann, sum[t]);
+            }
+        }
+    }
+
+    /* Neurons left over when n_out is not a multiple of tile. */
+    for (; j < n_out; ++j) {
+        double const *wr = w + j * row;
+        for (b = 0; b < n; ++b) {
+            double const *x = in + b * n_in;
+            double sum = wr[0] * -1.0;
+            for (k = 0; k < n_in; ++k) sum += wr[k + 1] * x[k];
+            out[b * n_out + j] = output_layer
+                ? genann_act_output(ann, sum)
+                : genann_act_hidden(ann, sum);
+        }
+    }
+}
+
+/* Instantiate genann_layer with a constant tile so the inner loop unrolls. */
+static void genann_layer_tiled(genann const *ann, int output_layer, double const *w,
+        int n_in, int n_out, int n, double const *in, double *out, int tile) {
+    switch (tile) {
+        case 8: genann_layer(ann, output_layer, w, n_in, n_out, n, in, out, 8); break;
+        case 4: genann_layer(ann, output_layer, w, n_in, n_out, n, in, out, 4); break;
+        case 2: genann_layer(ann, output_layer, w, n_in, n_out, n, in, out, 2); break;
+        default: genann_layer(ann, output_layer, w, n_in, n_out, n, in, out, 1); break;
+    }
+}
+
+
+double const *genann_run_tiled(genann const *ann, double const *inputs) {
+    double const *w = ann->weight;
+    double *o = ann->output + ann->inputs;
+    double const *i = ann->output;
+    int n_in = ann->inputs;
+    int h;
+
+    memcpy(ann->output, inputs, sizeof(double) * ann->inputs);
+
+    for (h = 0; h < ann->hidden_layers; ++h) {
+        genann_layer_tiled(ann, 0, w, n_in, ann->hidden_sizes[h], 1, i, o, ann->tuning.tile);
+        w += (n_in + 1) * ann->hidden_sizes[h];
+        i = o;
+        o += ann->hidden_sizes[h];
+        n_in = ann->hidden_sizes[h];
+    }
+
+    genann_layer_tiled(ann, 1, w, n_in, ann->outputs, 1, i, o, ann->tuning.tile);
+
+    assert(w + (n_in + 1) * ann->outputs - ann->weight == ann->total_weights);
+
+    return o;
+}
+
+
+int genann_run_batch(genann const *ann, int n, double const *inputs, double *outputs) {
+    double const *w = ann->weight;
+    double const *i = inputs;
+    double *scratch = NULL;
+    int n_in = ann->inputs;
+    int h;
+
+    /* Two of the widest layer's outputs, used alternately. */
+    if (ann->hidden_layers) {
+        scratch = malloc(sizeof(double) * 2 * n * ann->hidden);
+        if (!scratch) return 0;
+    }
+
+    for (h = 0; h < ann->hidden_layers; ++h) {
+        double *o = scratch + (h % 2) * n * ann->hidden;
+        genann_layer_tiled(ann, 0, w, n_in, ann->hidden_sizes[h], n, i, o, ann->tuning.tile);
+        w += (n_in + 1) * ann->hidden_sizes[h];
+        i = o;
+        n_in = ann->hidden_sizes[h];
+    }
+
+    genann_layer_tiled(ann, 1, w, n_in, ann->outputs, n, i, outputs, ann->tuning.tile);
+
+    free(scratch);
+    return 1;
+}
+
+
 void genann_train(genann const *ann, double const *inputs, double const *desired_outputs, double learning_rate) {
     /* To begin with, we must run the network forward. */
     genann_run(ann, inputs);
 
     int h, j, k;
+    const int layers = ann->hidden_layers;
+
+    /* Size and number of inputs of each layer (hidden layers, then the
+     * output layer), and where its outputs and weights start. */
+    int size[layers + 1], in[layers + 1], out[layers + 1], first_weight[layers + 1];
+    for (h = 0; h <= layers; ++h) {
+        size[h] = h < layers ? ann->hidden_sizes[h] : ann->outputs;
+        in[h] = h ? size[h-1] : ann->inputs;
+        out[h] = h ? out[h-1] + size[h-1] : ann->inputs;
+        first_weight[h] = h ? first_weight[h-1] + (in[h-1]+1) * size[h-1] : 0;
+    }
 
     /* First set the output layer deltas. */
     {
-        double const *o = ann->output + ann->inputs + ann->hidden * ann->hidden_layers; /* First output. */
-        double *d = ann->delta + ann->hidden * ann->hidden_layers; /* First delta. */
+        double const *o = ann->output + out[layers]; /* First output. */
+        double *d = ann->delta + out[layers] - ann->inputs; /* First delta. */
         double const *t = desired_outputs; /* First desired output. */
 
 
@@ -331,25 +534,25 @@ void genann_train(genann const *ann, double const *inputs, double const *desired
 
     /* Set hidden layer deltas, start on last layer and work backwards. */
     /* Note that loop is skipped in the case of hidden_layers == 0. */
-    for (h = ann->hidden_layers - 1; h >= 0; --h) {
+    for (h = layers - 1; h >= 0; --h) {
 
         /* Find first output and delta in this layer. */
-        double const *o = ann->output + ann->inputs + (h * ann->hidden);
-        double *d = ann->delta + (h * ann->hidden);
+        double const *o = ann->output + out[h];
+        double *d = ann->delta + out[h] - ann->inputs;
 
         /* Find first delta in following layer (which may be hidden or output). */
-        double const * const dd = ann->delta + ((h+1) * ann->hidden);
+        double const * const dd = ann->delta + out[h+1] - ann->inputs;
 
         /* Find first weight in following layer (which may be hidden or output). */
-        double const * const ww = ann->weight + ((ann->inputs+1) * ann->hidden) + ((ann->hidden+1) * ann->hidden * (h));
+        double const * const ww = ann->weight + first_weight[h+1];
 
-        for (j = 0; j < ann->hidden; ++j) {
+        for (j = 0; j < size[h]; ++j) {
 
             double delta = 0;
 
-            for (k = 0; k < (h == ann->hidden_layers-1 ? ann->outputs : ann->hidden); ++k) {
+            for (k = 0; k < size[h+1]; ++k) {
                 const double forward_delta = dd[k];
-                const int windex = k * (ann->hidden + 1) + (j + 1);
+                const int windex = k * (size[h] + 1) + (j + 1);
                 const double forward_weight = ww[windex];
                 delta += forward_delta * forward_weight;
             }
@@ -363,22 +566,18 @@ void genann_train(genann const *ann, double const *inputs, double const *desired
     /* Train the outputs. */
     {
         /* Find first output delta. */
-        double const *d = ann->delta + ann->hidden * ann->hidden_layers; /* First output delta. */
+        double const *d = ann->delta + out[layers] - ann->inputs; /* First output delta. */
 
         /* Find first weight to first output delta. */
-        double *w = ann->weight + (ann->hidden_layers
-                ? ((ann->inputs+1) * ann->hidden + (ann->hidden+1) * ann->hidden * (ann->hidden_layers-1))
-                : (0));
+        double *w = ann->weight + first_weight[layers];
 
         /* Find first output in previous layer. */
-        double const * const i = ann->output + (ann->hidden_layers
-                ? (ann->inputs + (ann->hidden) * (ann->hidden_layers-1))
-                : 0);
+        double const * const i = ann->output + out[layers] - in[layers];
 
         /* Set output layer weights. */
         for (j = 0; j < ann->outputs; ++j) {
             *w++ += *d * learning_rate * -1.0;
-            for (k = 1; k < (ann->hidden_layers ? ann->hidden : ann->inputs) + 1; ++k) {
+            for (k = 1; k < in[layers] + 1; ++k) {
                 *w++ += *d * learning_rate * i[k-1];
             }
 
@@ -390,25 +589,21 @@ void genann_train(genann const *ann, double const *inputs, double const *desired
 
 
     /* Train the hidden layers. */
-    for (h = ann->hidden_layers - 1; h >= 0; --h) {
+    for (h = layers - 1; h >= 0; --h) {
 
         /* Find first delta in this layer. */
-        double const *d = ann->delta + (h * ann->hidden);
+        double const *d = ann->delta + out[h] - ann->inputs;
 
         /* Find first input to this layer. */
-        double const *i = ann->output + (h
-                ? (ann->inputs + ann->hidden * (h-1))
-                : 0);
+        double const *i = ann->output + out[h] - in[h];
 
         /* Find first weight to this layer. */
-        double *w = ann->weight + (h
-                ? ((ann->inputs+1) * ann->hidden + (ann->hidden+1) * (ann->hidden) * (h-1))
-                : 0);
+        double *w = ann->weight + first_weight[h];
 
 
-        for (j = 0; j < ann->hidden; ++j) {
+        for (j = 0; j < size[h]; ++j) {
             *w++ += *d * learning_rate * -1.0;
-            for (k = 1; k < (h == 0 ? ann->inputs : ann->hidden) + 1; ++k) {
+            for (k = 1; k < in[h] + 1; ++k) {
                 *w++ += *d * learning_rate * i[k-1];
             }
             ++d;
@@ -420,20 +615,56 @@ void genann_train(genann const *ann, double const *inputs, double const *desired
 
 
 void genann_write(genann const *ann, FILE *out) {
-    fprintf(out, "%d %d %d %d", ann->inputs, ann->hidden_layers, ann->hidden, ann->outputs);
+    const int uniform = genann_uniform(ann);
+    fprintf(out, "%d %d %d %d", ann->inputs, ann->hidden_layers, uniform ? ann->hidden : -1, ann->outputs);
 
     int i;
+    if (!uniform) {
+        for (i = 0; i < ann->hidden_layers; ++i) {
+            fprintf(out, " %d", ann->hidden_sizes[i]);
+        }
+    }
+
     for (i = 0; i < ann->total_weights; ++i) {
         fprintf(out, " %.20e", ann->weight[i]);
     }
 }
 
 void genann_binary_write(const genann *ann, FILE *out) {
+    const int uniform = genann_uniform(ann);
     int config[4];
     config[0] = ann->inputs;
     config[1] = ann->hidden_layers;
-    config[2] = ann->hidden;
+    config[2] = uniform ? ann->hidden : -1;
     config[3] = ann->outputs;
     fwrite(config, sizeof(int), 4, out);
+    if (!uniform) fwrite(ann->hidden_sizes, sizeof(int), ann->hidden_layers, out);
     fwrite(ann->weight, sizeof(double), ann->total_weights, out);
 }
+
+
+int genann_tuning_read(genann *ann, FILE *in) {
+    char line[256];
+    int found = 0;
+
+    while (fgets(line, sizeof(line), in)) {
+        int inputs, hidden_layers, hidden, outputs, tile, batch;
+        if (line[0] == '#') continue;
+        if (sscanf(line, "%d %d %d %d %d %d", &inputs, &hidden_layers, &hidden, &outputs, &tile, &batch) < 6) continue;
+        if (inputs != ann->inputs || hidden_layers != ann->hidden_layers ||
+                hidden != ann->hidden || outputs != ann->outputs) continue;
+        if (tile < 1 || batch < 1) continue;
+
+        /* Later entries win, so a re-tuned topology can just be appended. */
+        ann->tuning.tile = tile;
+        ann->tuning.batch = batch;
+        found = 1;
+    }
+
+    return found;
+}
+
+void genann_tuning_write(genann const *ann, FILE *out) {
+    fprintf(out, "%d %d %d %d %d %d\n", ann->inputs, ann->hidden_layers, ann->hidden, ann->outputs,
+            ann->tuning.tile, ann->tuning.batch);
+}
@@ -42,8 +42,17 @@ struct genann;
 
 typedef double (*genann_actfun)(const struct genann *ann, double a);
 
+/* Kernel configuration for the blocked inference paths. */
+typedef struct genann_tuning {
+    /* How many neurons of a layer are computed per pass over its inputs. */
+    int tile;
+
+    /* How many positions callers should hand to genann_run_batch at once. */
+    int batch;
+} genann_tuning;
+
 typedef struct genann {
-    /* How many inputs, outputs, and hidden neurons. */
+    /* How many inputs, outputs, and hidden neurons (in the widest hidden layer). */
     int inputs, hidden_layers, hidden, outputs;
 
     /* Which activation function to use for hidden neurons. Default: gennann_act_sigmoid_cached*/
@@ -67,29 +76,54 @@ typedef struct genann {
     /* Stores delta of each hidden and output neuron (total_neurons - inputs long). */
     double *delta;
 
+    /* Neurons in each hidden layer (hidden_layers long). */
+    int *hidden_sizes;
+
+    /* Kernel configuration used by genann_run_tiled. Default: no tiling, no batching. */
+    genann_tuning tuning;
+
 } genann;
 
 /* Creates and returns a new ann. */
 genann *genann_init(int inputs, int hidden_layers, int hidden, int outputs);
 
+/* Creates and returns a new ann whose hidden layers have the given sizes. */
+genann *genann_init_layers(int inputs, int hidden_layers, int const *hidden, int outputs);
+
 /* Creates ANN from file saved with genann_write. */
 genann *genann_read(FILE *in);
 
 /* Creates ANN from file saved with genann_binary_write. */
 genann *genann_binary_read(FILE *in);
 
+/* Reads the weights of a file saved with genann_binary_write into ann, reusing
+ * its memory. Returns 0 and leaves ann alone if the file holds another topology
+ * or is cut short. */
+int genann_binary_read_into(genann *ann, FILE *in);
+
 /* Sets weights randomly. Called by init. */
 void genann_randomize(genann *ann);
 
 /* Returns a new copy of ann. */
 genann *genann_copy(genann const *ann);
 
+/* Returns the number of bytes used by an ann. */
+int genann_size(genann const *ann);
+
 /* Frees the memory used by an ann. */
 void genann_free(genann *ann);
 
 /* Runs the feedforward algorithm to calculate the ann's output. */
 double const *genann_run(genann const *ann, double const *inputs);
 
+/* Same result as genann_run, but computes ann->tuning.tile neurons per pass over the inputs. */
+double const *genann_run_tiled(genann const *ann, double const *inputs);
+
+/* Runs n positions at once. inputs is n * ann->inputs long, outputs n * ann->outputs long.
+ * Does not touch ann->output, so it is safe to call on a shared ann from several threads.
+ * Returns 0 if the scratch buffers could not be allocated. */
+int genann_run_batch(genann const *ann, int n, double const *inputs, double *outputs);
+
 /* Does a single backprop update. */
 void genann_train(genann const *ann, double const *inputs, double const *desired_outputs, double learning_rate);
 
@@ -98,6 +132,11 @@ void genann_write(genann const *ann, FILE *out);
 /* Saves the ann in a binary format. */
 void genann_binary_write(genann const *ann, FILE *out);
 
+/* Sets ann->tuning from the profile entry matching its topology. Returns 1 if one was found. */
+int genann_tuning_read(genann *ann, FILE *in);
+/* Writes the profile entry for ann's topology and tuning. */
+void genann_tuning_write(genann const *ann, FILE *out);
+
 void genann_init_sigmoid_lookup(const genann *ann);
 double genann_act_sigmoid(const genann *ann, double a);
 double genann_act_sigmoid_cached(const genann *ann, double a);
@@ -0,0 +1,108 @@
+/*
+
+MIT License
+
+Copyright (c) 2023 Urban Hafner
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "glicko.h"
+
+#include <math.h>
+
+/* Ratings are 173.7178 times the Glicko-2 scale, around 1500. */
+#define GLICKO_SCALE 173.7178
+#define GLICKO_TAU 0.5
+#define GLICKO_EPSILON 0.000001
+
+
+void glicko_init(glicko *player) {
+    player->rating = 1500;
+    player->deviation = 350;
+    player->volatility = 0.06;
+    player->games = 0;
+}
+
+
+/* Step 5 of the algorithm, the new volatility by the Illinois method. */
+static double glicko_f(double x, double delta2, double phi2, double v, double a) {
+    double ex = exp(x);
+    return ex * (delta2 - phi2 - v - ex) / (2 * (phi2 + v + ex) * (phi2 + v + ex))
+        - (x - a) / (GLICKO_TAU * GLICKO_TAU);
+}
+
+
+static double glicko_volatility(double sigma, double phi, double v, double delta) {
+    double a = log(sigma * sigma), delta2 = delta * delta, phi2 = phi * phi;
+    double A = a, B, C, fA, fB, fC;
+    int k = 1;
+
+    if (delta2 > phi2 + v) {
+        B = log(delta2 - phi2 - v);
+    } else {
+        while (glicko_f(a - k * GLICKO_TAU, delta2, phi2, v, a) < 0) k++;
+        B = a - k * GLICKO_TAU;
+    }
+
+    fA = glicko_f(A, delta2, phi2, v, a);
+    fB = glicko_f(B, delta2, phi2, v, a);
+    while (fabs(B - A) > GLICKO_EPSILON) {
+        C = A + (A - B) * fA / (fB - fA);
+        fC = glicko_f(C, delta2, phi2, v, a);
+        if (fC * fB <= 0) {
+            A = B;
+            fA = fB;
+        } else {
+            fA /= 2;
+        }
+        B = C;
+        fB = fC;
+    }
+    return exp(A / 2);
+}
+
+
+/* The player after a game against opponent with score 1 for a win. */
+static glicko glicko_rate(glicko player, glicko const *opponent, double score) {
+    double mu = (player.rating - 1500) / GLICKO_SCALE;
+    double phi = player.deviation / GLICKO_SCALE;
+    double mu_j = (opponent->rating - 1500) / GLICKO_SCALE;
+    double phi_j = opponent->deviation / GLICKO_SCALE;
+    double g = 1 / sqrt(1 + 3 * phi_j * phi_j / (M_PI * M_PI));
+    double e = 1 / (1 + exp(-g * (mu - mu_j)));
+    double v = 1 / (g * g * e * (1 - e));
+    double sigma = glicko_volatility(player.volatility, phi, v, v * g * (score - e));
+    double phi_star = sqrt(phi * phi + sigma * sigma);
+    double phi_new = 1 / sqrt(1 / (phi_star * phi_star) + 1 / v);
+
+    player.rating = 1500 + GLICKO_SCALE * (mu + phi_new * phi_new * g * (score - e));
+    player.deviation = GLICKO_SCALE * phi_new;
+    player.volatility = sigma;
+    player.games++;
+    return player;
+}
+
+
+void glicko_update(glicko *winner, glicko *loser) {
+    glicko before = *winner;
+    *winner = glicko_rate(*winner, loser, 1);
+    *loser = glicko_rate(*loser, &before, 0);
+}
@@ -0,0 +1,55 @@
+/*
+
+MIT License
+
+Copyright (c) 2023 Urban Hafner
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#ifndef GLICKO_H
+#define GLICKO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Glicko-2 ratings (Glickman, "Example of the Glicko-2 system"), updated
+ * after every game instead of once per rating period. A player starts at
+ * 1500 with a deviation of 350, which shrinks with every game and grows
+ * again with the volatility. */
+typedef struct glicko {
+    double rating;
+    double deviation;
+    double volatility;
+    int games;
+} glicko;
+
+void glicko_init(glicko *player);
+
+/* Rates one game. Both players are updated from the ratings they had
+ * before it. */
+void glicko_update(glicko *winner, glicko *loser);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*GLICKO_H*/
@@ -0,0 +1,404 @@
+/*
+
+MIT License
+
+Copyright (c) 2023 Urban Hafner
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "json.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct json_parser {
+    const char *p;
+    int failed;
+} json_parser;
+
+
+json_value *json_new(json_type type) {
+    json_value *value = calloc(1, sizeof(json_value));
+    if (value) value->type = type;
+    return value;
+}
+
+
+json_value *json_new_number(double number) {
+    json_value *value = json_new(JSON_NUMBER);
+    if (value) value->number = number;
+    return value;
+}
+
+
+json_value *json_new_string(const char *string) {
+    json_value *value = json_new(JSON_STRING);
+    if (value) value->string = strdup(string);
+    return value;
+}
+
+
+void json_free(json_value *value) {
+    int i;
+    if (!value) return;
+    for (i = 0; i < value->count; ++i) {
+        if (value->keys) free(value->keys[i]);
+        json_free(value->items[i]);
+    }
+    free(value->keys);
+    free(value->items);
+    free(value->string);
+    free(value);
+}
+
+
+static void json_add(json_value *container, char *key, json_value *value) {
+    if (container->count == container->capacity) {
+        container->capacity = container->capacity ? 2 * container->capacity : 8;
+        container->items = realloc(container->items, container->capacity * sizeof(json_value *));
+        if (container->type == JSON_OBJECT)
+            container->keys = realloc(container->keys, container->capacity * sizeof(char *));
+    }
+    if (container->type == JSON_OBJECT) container->keys[container->count] = key;
+    container->items[container->count++] = value;
+}
+
+
+json_value *json_get(json_value const *object, const char *key) {
+    int i;
+    if (!object || object->type != JSON_OBJECT) return NULL;
+    for (i = 0; i < object->count; ++i) {
+        if (!strcmp(object->keys[i], key)) return object->items[i];
+    }
+    return NULL;
+}
+
+
+void json_set(json_value *object, const char *key, json_value *value) {
+    int i;
+    for (i = 0; i < object->count; ++i) {
+        if (!strcmp(object->keys[i], key)) {
+            json_free(object->items[i]);
+            object->items[i] = value;
+            return;
+        }
+    }
+    json_add(object, strdup(key), value);
+}
+
+
+void json_append(json_value *array, json_value *value) {
+    json_add(array, NULL, value);
+}
+
+
+static void json_skip_space(json_parser *parser) {
+    while (*parser->p == ' ' || *parser->p == '\t' || *parser->p == '\n' || *parser->p == '\r') ++parser->p;
+}
+
+
+static int json_expect(json_parser *parser, const char *word) {
+    size_t n = strlen(word);
+    if (strncmp(parser->p, word, n)) {
+        parser->failed = 1;
+        return 0;
+    }
+    parser->p += n;
+    return 1;
+}
+
+
+/* Appends a code point as UTF-8. */
+static char *json_put_utf8(char *out, unsigned code) {
+    if (code < 0x80) {
+        *out++ = code;
+    } else if (code < 0x800) {
+        *out++ = 0xc0 | (code >> 6);
+        *out++ = 0x80 | (code & 0x3f);
+    } else {
+        *out++ = 0xe0 | (code >> 12);
+        *out++ = 0x80 | ((code >> 6) & 0x3f);
+        *out++ = 0x80 | (code & 0x3f);
+    }
+    return out;
+}
+
+
+/* Parses a string at the opening quote. Escapes only ever shrink, so the
+ * result fits in the length of the source. */
+static char *json_parse_string(json_parser *parser) {
+    const char *start = ++parser->p;
+    const char *end = start;
+    while (*end && *end != '"') end += (end[0] == '\\' && end[1]) ? 2 : 1;
+    if (*end != '"') {
+        parser->failed = 1;
+        return NULL;
+    }
+
+    char *string = malloc(end - start + 1);
+    char *out = string;
+    const char *p = start;
+    while (p < end) {
+        if (*p != '\\') {
+            *out++ = *p++;
+            continue;
+        }
+        switch (p[1]) {
+        case 'n': *out++ = '\n'; break;
+        case 't': *out++ = '\t'; break;
+        case 'r': *out++ = '\r'; break;
+        case 'b': *out++ = '\b'; break;
+        case 'f': *out++ = '\f'; break;
+        case 'u': {
+            unsigned code = 0;
+            if (sscanf(p + 2, "%4x", &code) == 1 && end - p >= 6) {
+                out = json_put_utf8(out, code);
+                p += 4;
+            }
+            break;
+        }
+        default: *out++ = p[1];
+        }
+        p += 2;
+    }
+    *out = '\0';
+    parser->p = end + 1;
+    return string;
+}
+
+
+static json_value *json_parse_value(json_parser *parser) {
+    json_value *value = NULL;
+
+    json_skip_space(parser);
+    switch (*parser->p) {
+    case '{':
+        value = json_new(JSON_OBJECT);
+        ++parser->p;
+        json_skip_space(parser);
+        if (*parser->p == '}') {
+            ++parser->p;
+            break;
+        }
+        while (!parser->failed) {
+            json_skip_space(parser);
+            if (*parser->p != '"') {
+                parser->failed = 1;
+                break;
+            }
+            char *key = json_parse_string(parser);
+            json_skip_space(parser);
+            if (!key || !json_expect(parser, ":")) {
+                free(key);
+                break;
+            }
+            json_value *member = json_parse_value(parser);
+            if (!member) {
+                free(key);
+                break;
+            }
+            json_add(value, key, member);
+            json_skip_space(parser);
+            if (*parser->p == ',') {
+                ++parser->p;
+            } else {
+                json_expect(parser, "}");
+                break;
+            }
+        }
+        break;
+    case '[':
+        value = json_new(JSON_ARRAY);
+        ++parser->p;
+        json_skip_space(parser);
+        if (*parser->p == ']') {
+            ++parser->p;
+            break;
+        }
+        while (!parser->failed) {
+            json_value *item = json_parse_value(parser);
+            if (!item) break;
+            json_append(value, item);
+            json_skip_space(parser);
+            if (*parser->p == ',') {
+                ++parser->p;
+            } else {
+                json_expect(parser, "]");
+                break;
+            }
+        }
+        break;
+    case '"':
+        value = json_new(JSON_STRING);
+        value->string = json_parse_string(parser);
+        break;
+    case 't':
+        if (json_expect(parser, "true")) value = json_new(JSON_TRUE);
+        break;
+    case 'f':
+        if (json_expect(parser, "false")) value = json_new(JSON_FALSE);
+        break;
+    case 'n':
+        if (json_expect(parser, "null")) value = json_new(JSON_NULL);
+        break;
+    default: {
+        char *end;
+        double number = strtod(parser->p, &end);
+        if (end == parser->p) {
+            parser->failed = 1;
+        } else {
+            value = json_new_number(number);
+            parser->p = end;
+        }
+    }
+    }
+
+    if (parser->failed) {
+        json_free(value);
+        return NULL;
+    }
+    return value;
+}
+
+
+json_value *json_parse(const char *text) {
+    json_parser parser = {text, 0};
+    json_value *value = json_parse_value(&parser);
+    json_skip_space(&parser);
+    if (value && *parser.p) {
+        json_free(value);
+        return NULL;
+    }
+    return value;
+}
+
+
+json_value *json_read_file(const char *path) {
+    FILE *fd = fopen(path, "rb");
+    if (!fd) return NULL;
+
+    fseek(fd, 0, SEEK_END);
+    long size = ftell(fd);
+    fseek(fd, 0, SEEK_SET);
+    char *text = malloc(size + 1);
+    size_t read = fread(text, 1, size, fd);
+    fclose(fd);
+    text[read] = '\0';
+
+    json_value *value = json_parse(text);
+    free(text);
+    return value;
+}
+
+
+static void json_write_string(FILE *out, const char *string) {
+    const unsigned char *p;
+    fputc('"', out);
+    for (p = (const unsigned char *)string; *p; ++p) {
+        if (*p == '"' || *p == '\\') fprintf(out, "\\%c", *p);
+        else if (*p == '\n') fputs("\\n", out);
+        else if (*p == '\t') fputs("\\t", out);
+        else if (*p == '\r') fputs("\\r", out);
+        else if (*p < 0x20) fprintf(out, "\\u%04x", *p);
+        else fputc(*p, out);
+    }
+    fputc('"', out);
+}
+
+
+/* The shortest form that reads back the same. */
+static void json_write_number(FILE *out, double number) {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.15g", number);
+    if (strtod(buffer, NULL) != number) snprintf(buffer, sizeof(buffer), "%.17g", number);
+    fputs(buffer, out);
+}
+
+
+/* Pretty with depth >= 0, on one line with depth < 0. */
+static void json_write_indented(FILE *out, json_value const *value, int depth) {
+    int i;
+    switch (value->type) {
+    case JSON_NULL: fputs("null", out); break;
+    case JSON_FALSE: fputs("false", out); break;
+    case JSON_TRUE: fputs("true", out); break;
+    case JSON_NUMBER: json_write_number(out, value->number); break;
+    case JSON_STRING: json_write_string(out, value->string); break;
+    case JSON_ARRAY:
+    case JSON_OBJECT:
+        if (!value->count) {
+            fputs(value->type == JSON_ARRAY ? "[]" : "{}", out);
+            break;
+        }
+        if (depth < 0) {
+            fputc(value->type == JSON_ARRAY ? '[' : '{', out);
+            for (i = 0; i < value->count; ++i) {
+                if (i) fputc(',', out);
+                if (value->type == JSON_OBJECT) {
+                    json_write_string(out, value->keys[i]);
+                    fputc(':', out);
+                }
+                json_write_indented(out, value->items[i], depth);
+            }
+            fputc(value->type == JSON_ARRAY ? ']' : '}', out);
+            break;
+        }
+        fputs(value->type == JSON_ARRAY ? "[\n" : "{\n", out);
+        for (i = 0; i < value->count; ++i) {
+            fprintf(out, "%*s", 2 * (depth + 1), "");
+            if (value->type == JSON_OBJECT) {
+                json_write_string(out, value->keys[i]);
+                fputs(": ", out);
+            }
+            json_write_indented(out, value->items[i], depth + 1);
+            fputs(i + 1 < value->count ? ",\n" : "\n", out);
+        }
+        fprintf(out, "%*s%c", 2 * depth, "", value->type == JSON_ARRAY ? ']' : '}');
+        break;
+    }
+}
+
+
+void json_write(FILE *out, json_value const *value) {
+    json_write_indented(out, value, 0);
+    fputc('\n', out);
+}
+
+
+void json_write_line(FILE *out, json_value const *value) {
+    json_write_indented(out, value, -1);
+    fputc('\n', out);
+}
+
+
+int json_write_file(const char *path, json_value const *value) {
+    char temporary[4096];
+    snprintf(temporary, sizeof(temporary), "%s.tmp", path);
+
+    FILE *fd = fopen(temporary, "w");
+    if (!fd) return 0;
+    json_write(fd, value);
+    if (fclose(fd) || rename(temporary, path)) {
+        remove(temporary);
+        return 0;
+    }
+    return 1;
+}
@@ -0,0 +1,99 @@
+/*
+
+MIT License
+
+Copyright (c) 2023 Urban Hafner
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#ifndef JSON_H
+#define JSON_H
+
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Just enough JSON for the files of an experiment: settings.json, and the
+ * data.json and journal.jsonl of a generation. Values form a tree that
+ * owns everything below it. */
+
+typedef enum json_type {
+    JSON_NULL,
+    JSON_FALSE,
+    JSON_TRUE,
+    JSON_NUMBER,
+    JSON_STRING,
+    JSON_ARRAY,
+    JSON_OBJECT
+} json_type;
+
+typedef struct json_value {
+    json_type type;
+    double number;
+    char *string;
+
+    /* Items of an array or members of an object, which also have keys. */
+    int count;
+    int capacity;
+    char **keys;
+    struct json_value **items;
+} json_value;
+
+json_value *json_parse(const char *text);
+
+json_value *json_read_file(const char *path);
+
+/* Writes the way Ruby's JSON.pretty_generate does. */
+void json_write(FILE *out, json_value const *value);
+
+/* Writes on one line the way Ruby's JSON.generate does, followed by a
+ * newline. */
+void json_write_line(FILE *out, json_value const *value);
+
+/* Writes to a temporary file first and renames it, so readers never see
+ * a partly written file. Returns 0 on failure. */
+int json_write_file(const char *path, json_value const *value);
+
+void json_free(json_value *value);
+
+json_value *json_new(json_type type);
+
+json_value *json_new_number(double number);
+
+json_value *json_new_string(const char *string);
+
+/* The member of an object, or NULL. */
+json_value *json_get(json_value const *object, const char *key);
+
+/* Replaces the member with the same key, or appends a new one. Takes
+ * ownership of value. */
+void json_set(json_value *object, const char *key, json_value *value);
+
+/* Takes ownership of value. */
+void json_append(json_value *array, json_value *value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*JSON_H*/
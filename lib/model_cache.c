@@ -0,0 +1,307 @@
+/*
+
+MIT License
+
+Copyright (c) 2023 Urban Hafner
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "model_cache.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct model_cache_entry {
+    char *path;
+    genann *ann;
+    size_t bytes;
+
+    /* How many model_cache_get calls have not been released yet. */
+    int refs;
+
+    /* Set while the net is read from disk. ann is NULL until then. */
+    int loading;
+
+    /* Position in the LRU list, most recently used first. */
+    struct model_cache_entry *prev, *next;
+} model_cache_entry;
+
+typedef struct model_cache_request {
+    char *path;
+    struct model_cache_request *next;
+} model_cache_request;
+
+struct model_cache {
+    size_t budget;
+    model_cache_counters counters;
+
+    model_cache_entry *head, *tail;
+
+    /* Paths waiting for the prefetch thread, oldest first. */
+    model_cache_request *queue, *queue_tail;
+    int prefetching;
+    int stop;
+
+    pthread_mutex_t lock;
+    /* Signalled when a net finished loading or the queue changed. */
+    pthread_cond_t changed;
+    pthread_t thread;
+};
+
+
+static genann *model_cache_load(const char *path) {
+    FILE *fd = fopen(path, "rb");
+    if (!fd) return NULL;
+
+    genann *ann = genann_binary_read(fd);
+    fclose(fd);
+    return ann;
+}
+
+
+static void model_cache_unlink(model_cache *cache, model_cache_entry *e) {
+    if (e->prev) e->prev->next = e->next; else cache->head = e->next;
+    if (e->next) e->next->prev = e->prev; else cache->tail = e->prev;
+    e->prev = e->next = NULL;
+}
+
+
+static void model_cache_push_front(model_cache *cache, model_cache_entry *e) {
+    e->prev = NULL;
+    e->next = cache->head;
+    if (cache->head) cache->head->prev = e; else cache->tail = e;
+    cache->head = e;
+}
+
+
+static model_cache_entry *model_cache_find(model_cache *cache, const char *path) {
+    model_cache_entry *e;
+    for (e = cache->head; e; e = e->next) {
+        if (!strcmp(e->path, path)) return e;
+    }
+    return NULL;
+}
+
+
+static void model_cache_drop(model_cache *cache, model_cache_entry *e) {
+    model_cache_unlink(cache, e);
+    cache->counters.bytes -= e->bytes;
+    genann_free(e->ann);
+    free(e->path);
+    free(e);
+}
+
+
+/* Evicts unused nets from the back of the list until the budget is met. */
+static void model_cache_evict(model_cache *cache) {
+    model_cache_entry *e = cache->tail;
+    while (e && cache->counters.bytes > cache->budget) {
+        model_cache_entry *prev = e->prev;
+        if (!e->refs && !e->loading) {
+            model_cache_drop(cache, e);
+            ++cache->counters.evictions;
+        }
+        e = prev;
+    }
+}
+
+
+/* Loads the net of a new entry without holding the lock. Returns 0 and
+ * removes the entry if the file cannot be read. */
+static int model_cache_fill(model_cache *cache, model_cache_entry *e) {
+    pthread_mutex_unlock(&cache->lock);
+    genann *ann = model_cache_load(e->path);
+    pthread_mutex_lock(&cache->lock);
+
+    e->loading = 0;
+    pthread_cond_broadcast(&cache->changed);
+    if (!ann) {
+        model_cache_drop(cache, e);
+        return 0;
+    }
+
+    e->ann = ann;
+    e->bytes = genann_size(ann);
+    cache->counters.bytes += e->bytes;
+    model_cache_evict(cache);
+    return 1;
+}
+
+
+static model_cache_entry *model_cache_insert(model_cache *cache, const char *path) {
+    model_cache_entry *e = calloc(1, sizeof(model_cache_entry));
+    if (!e) return NULL;
+    e->path = strdup(path);
+    e->loading = 1;
+    model_cache_push_front(cache, e);
+    return e;
+}
+
+
+static void *model_cache_prefetcher(void *arg) {
+    model_cache *cache = arg;
+
+    pthread_mutex_lock(&cache->lock);
+    for (;;) {
+        while (!cache->queue && !cache->stop) {
+            pthread_cond_wait(&cache->changed, &cache->lock);
+        }
+        if (cache->stop) break;
+
+        model_cache_request *r = cache->queue;
+        cache->queue = r->next;
+        if (!cache->queue) cache->queue_tail = NULL;
+
+        if (!model_cache_find(cache, r->path)) {
+            model_cache_entry *e = model_cache_insert(cache, r->path);
+            cache->prefetching = 1;
+            if (e && model_cache_fill(cache, e)) {
+                ++cache->counters.prefetches;
+            }
+            cache->prefetching = 0;
+        }
+
+        free(r->path);
+        free(r);
+        pthread_cond_broadcast(&cache->changed);
+    }
+    pthread_mutex_unlock(&cache->lock);
+
+    return NULL;
+}
+
+
+model_cache *model_cache_create(size_t budget) {
+    model_cache *cache = calloc(1, sizeof(model_cache));
+    if (!cache) return NULL;
+
+    cache->budget = budget;
+    pthread_mutex_init(&cache->lock, NULL);
+    pthread_cond_init(&cache->changed, NULL);
+    if (pthread_create(&cache->thread, NULL, model_cache_prefetcher, cache)) {
+        free(cache);
+        return NULL;
+    }
+
+    return cache;
+}
+
+
+void model_cache_free(model_cache *cache) {
+    pthread_mutex_lock(&cache->lock);
+    cache->stop = 1;
+    pthread_cond_broadcast(&cache->changed);
+    pthread_mutex_unlock(&cache->lock);
+    pthread_join(cache->thread, NULL);
+
+    while (cache->queue) {
+        model_cache_request *r = cache->queue;
+        cache->queue = r->next;
+        free(r->path);
+        free(r);
+    }
+    while (cache->head) {
+        model_cache_drop(cache, cache->head);
+    }
+
+    pthread_cond_destroy(&cache->changed);
+    pthread_mutex_destroy(&cache->lock);
+    free(cache);
+}
+
+
+genann *model_cache_get(model_cache *cache, const char *path) {
+    genann *ann = NULL;
+
+    pthread_mutex_lock(&cache->lock);
+
+    model_cache_entry *e = model_cache_find(cache, path);
+    /* Someone else is loading it already, wait for them. */
+    while (e && e->loading) {
+        pthread_cond_wait(&cache->changed, &cache->lock);
+        e = model_cache_find(cache, path);
+    }
+
+    if (e) {
+        ++cache->counters.hits;
+        ++e->refs;
+        model_cache_unlink(cache, e);
+        model_cache_push_front(cache, e);
+    } else {
+        ++cache->counters.misses;
+        e = model_cache_insert(cache, path);
+        /* Pinned before loading, so the eviction after the load leaves it alone. */
+        if (e) e->refs = 1;
+        if (e && !model_cache_fill(cache, e)) e = NULL;
+    }
+
+    if (e) ann = e->ann;
+
+    pthread_mutex_unlock(&cache->lock);
+    return ann;
+}
+
+
+void model_cache_release(model_cache *cache, genann const *ann) {
+    model_cache_entry *e;
+
+    pthread_mutex_lock(&cache->lock);
+    for (e = cache->head; e; e = e->next) {
+        if (e->ann == ann) {
+            --e->refs;
+            break;
+        }
+    }
+    model_cache_evict(cache);
+    pthread_mutex_unlock(&cache->lock);
+}
+
+
+void model_cache_prefetch(model_cache *cache, const char *path) {
+    model_cache_request *r = malloc(sizeof(model_cache_request));
+    if (!r) return;
+    r->path = strdup(path);
+    r->next = NULL;
+
+    pthread_mutex_lock(&cache->lock);
+    if (cache->queue_tail) cache->queue_tail->next = r; else cache->queue = r;
+    cache->queue_tail = r;
+    pthread_cond_broadcast(&cache->changed);
+    pthread_mutex_unlock(&cache->lock);
+}
+
+
+void model_cache_drain(model_cache *cache) {
+    pthread_mutex_lock(&cache->lock);
+    while (cache->queue || cache->prefetching) {
+        pthread_cond_wait(&cache->changed, &cache->lock);
+    }
+    pthread_mutex_unlock(&cache->lock);
+}
+
+
+model_cache_counters model_cache_get_counters(model_cache *cache) {
+    pthread_mutex_lock(&cache->lock);
+    model_cache_counters counters = cache->counters;
+    pthread_mutex_unlock(&cache->lock);
+    return counters;
+}
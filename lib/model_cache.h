@@ -0,0 +1,87 @@
+/*
+
+MIT License
+
+Copyright (c) 2023 Urban Hafner
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#ifndef MODEL_CACHE_H
+#define MODEL_CACHE_H
+
+#include <stddef.h>
+
+#include "genann.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Keeps recently used nets in memory within a byte budget. Nets are
+ * loaded with genann_binary_read and evicted least recently used first.
+ * All functions can be called from several threads. */
+typedef struct model_cache model_cache;
+
+typedef struct model_cache_counters {
+    /* Nets found in memory (including ones loaded by a prefetch). */
+    long hits;
+
+    /* Nets that had to be loaded by model_cache_get. */
+    long misses;
+
+    /* Nets dropped to stay within the budget. */
+    long evictions;
+
+    /* Nets loaded in the background by model_cache_prefetch. */
+    long prefetches;
+
+    /* Bytes currently used by the cached nets. */
+    size_t bytes;
+} model_cache_counters;
+
+/* Creates a cache that holds at most budget bytes of nets, and starts its prefetch thread. */
+model_cache *model_cache_create(size_t budget);
+
+/* Stops the prefetch thread and frees every net. No net may be in use. */
+void model_cache_free(model_cache *cache);
+
+/* Returns the net saved in path, loading it if needed, or NULL if it cannot be read.
+ * The net is not evicted until it is handed back with model_cache_release. If every
+ * net is in use the cache goes over its budget rather than fail. */
+genann *model_cache_get(model_cache *cache, const char *path);
+
+/* Hands back a net returned by model_cache_get. */
+void model_cache_release(model_cache *cache, genann const *ann);
+
+/* Queues the net saved in path to be loaded in the background, e.g. for
+ * the next pairings of a tournament. */
+void model_cache_prefetch(model_cache *cache, const char *path);
+
+/* Waits until every queued prefetch has been loaded. */
+void model_cache_drain(model_cache *cache);
+
+model_cache_counters model_cache_get_counters(model_cache *cache);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*MODEL_CACHE_H*/
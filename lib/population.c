@@ -0,0 +1,97 @@
+/*
+
+MIT License
+
+Copyright (c) 2023 Urban Hafner
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "population.h"
+
+#include <pthread.h>
+
+#define MAX_THREADS 64
+
+typedef struct population_job {
+    genann const *const *anns;
+    double const *inputs;
+    double *outputs;
+    /* This worker runs nets first, first + step, first + 2 * step, ... */
+    int first, step, k;
+    int ok;
+} population_job;
+
+
+static void *population_worker(void *arg) {
+    population_job *job = arg;
+    int n;
+
+    job->ok = 1;
+    for (n = job->first; n < job->k; n += job->step) {
+        genann const *ann = job->anns[n];
+        /* genann_run_batch leaves ann->output alone, so nets may even be shared. */
+        if (!genann_run_batch(ann, 1, job->inputs, job->outputs + n * ann->outputs)) job->ok = 0;
+    }
+
+    return NULL;
+}
+
+
+int genann_run_population(genann const *const *anns, int k, double const *inputs, double *outputs, int threads) {
+    pthread_t thread[MAX_THREADS];
+    population_job job[MAX_THREADS];
+    int t, ok = 1;
+
+    if (threads > k) threads = k;
+    if (threads > MAX_THREADS) threads = MAX_THREADS;
+    if (threads < 1) threads = 1;
+
+    for (t = 0; t < threads; ++t) {
+        job[t].anns = anns;
+        job[t].inputs = inputs;
+        job[t].outputs = outputs;
+        job[t].first = t;
+        job[t].step = threads;
+        job[t].k = k;
+    }
+
+    /* The calling thread takes the first share itself. */
+    for (t = 1; t < threads; ++t) {
+        if (pthread_create(&thread[t], NULL, population_worker, &job[t])) {
+            threads = t;
+            break;
+        }
+    }
+    for (t = threads; t < job[0].step; ++t) {
+        /* Threads that could not be started: run their nets here. */
+        population_worker(&job[t]);
+        ok &= job[t].ok;
+    }
+    population_worker(&job[0]);
+    ok &= job[0].ok;
+
+    for (t = 1; t < threads; ++t) {
+        pthread_join(thread[t], NULL);
+        ok &= job[t].ok;
+    }
+
+    return ok;
+}
@@ -0,0 +1,45 @@
+/*
+
+MIT License
+
+Copyright (c) 2023 Urban Hafner
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#ifndef POPULATION_H
+#define POPULATION_H
+
+#include "genann.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Runs the same inputs through k nets in one call, spreading the nets over
+ * up to threads threads. The nets must agree on the number of inputs and
+ * outputs. outputs is k * outputs long, net by net. Returns 0 on failure. */
+int genann_run_population(genann const *const *anns, int k, double const *inputs, double *outputs, int threads);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*POPULATION_H*/
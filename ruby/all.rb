@@ -1,4 +1,9 @@
 require_relative "build_dependencies"
 require_relative "setup_experiment"
 require_relative "run_experiment"
+require_relative "gtp_engine"
+require_relative "pooled_game"
+require_relative "journal"
+require_relative "scheduler"
+require_relative "scheduler_client"
 require_relative "run_generation"
@@ -0,0 +1,33 @@
+# A GTP engine running as a child process, which stays up between games
+class GtpEngine
+  def initialize(command)
+    self.io = IO.popen(command, 'r+', err: File::NULL)
+  end
+
+  # Sends one command and returns the response without the leading '= '
+  def command(line)
+    io.puts(line)
+    io.flush
+    lines = []
+    while (response = io.gets)
+      response = response.chomp
+      break if response.empty? && !lines.empty?
+
+      lines << response unless response.empty?
+    end
+    raise "#{line}: #{lines.join("\n")}" if lines.empty? || lines.first.start_with?('?')
+
+    lines.join("\n")[1..].strip
+  end
+
+  def close
+    command('quit')
+    io.close
+  rescue StandardError
+    nil
+  end
+
+  private
+
+  attr_accessor :io
+end
@@ -0,0 +1,71 @@
+require 'json'
+
+# The tournament of a generation. data.json is a snapshot, which is only
+# rewritten when a round starts, by writing a new file and renaming it
+# over the old one. Every game result in between is appended to
+# journal.jsonl as one line. The snapshot records how much of the
+# journal it already includes, so the tournament is the snapshot plus
+# the results after that offset. Readers ignore a last line without its
+# newline, so they never see a half written file.
+class Journal
+  SNAPSHOT = 'data.json'
+  JOURNAL = 'journal.jsonl'
+
+  # The tournament in dir, or nil before it is set up
+  def self.load(dir = '.')
+    snapshot = File.join(dir, SNAPSHOT)
+    return nil unless File.exist?(snapshot)
+
+    data = JSON.load_file(snapshot)
+    results(File.join(dir, JOURNAL), data['journal'] || 0).each { |result| apply(data, result) }
+    data.merge('ranking' => rank(data['ranking']))
+  end
+
+  def self.results(path, offset)
+    return [] unless File.exist?(path)
+
+    tail = File.open(path, 'rb') do |f|
+      f.seek(offset)
+      f.read
+    end
+    tail.lines.select { |line| line.end_with?("\n") }.map { |line| JSON.parse(line) }
+  end
+
+  # Finish the game of the result, unless it is finished already
+  def self.apply(data, result)
+    game = data['games'].find { |g| g['black'] == result['black'] && g['white'] == result['white'] }
+    return unless game
+
+    data['games'].delete(game)
+    winner = data['ranking'].find { |s| s['name'] == result['winner'] }
+    winner['score'] += result['points']
+  end
+
+  # Highest score (or other key) first, in random order within the same score
+  def self.rank(ranking, key = 'score')
+    groups = ranking.group_by { |s| s[key] }
+    groups.keys.sort.reverse.flat_map { |s| groups[s].shuffle }
+  end
+
+  # Appends the result in a single write, after removing what a crash
+  # left of the line before
+  def self.append(result)
+    File.open(JOURNAL, 'a+') do |f|
+      size = f.size
+      if size.positive?
+        f.seek(size - 1)
+        unless f.read(1) == "\n"
+          f.seek(0)
+          f.truncate(f.read.rindex("\n")&.succ || 0)
+        end
+      end
+      f.syswrite("#{JSON.generate(result)}\n")
+    end
+  end
+
+  def self.snapshot(data)
+    offset = File.exist?(JOURNAL) ? File.size(JOURNAL) : 0
+    File.write("#{SNAPSHOT}.tmp", "#{JSON.pretty_generate(data.merge('journal' => offset))}\n")
+    File.rename("#{SNAPSHOT}.tmp", SNAPSHOT)
+  end
+end
@@ -0,0 +1,84 @@
+# Plays a game between two nets on engines from the pool. The nets are
+# swapped in with evo-load_network, so the engines keep running between
+# games. The result is written to <prefix>.dat and <prefix>-0.sgf the
+# way gogui-twogtp writes them.
+class PooledGame
+  def self.call(engines, game)
+    new(engines, game).call
+  end
+
+  def initialize(engines, game)
+    self.black, self.white = engines
+    self.game = game
+  end
+
+  def call
+    black.command("evo-load_network #{game['black']}")
+    white.command("evo-load_network #{game['white']}")
+    [black, white].each do |engine|
+      engine.command("boardsize #{game['size']}")
+      engine.command('clear_board')
+      engine.command("komi #{game['komi']}")
+    end
+
+    moves = play
+    result = black.command('final_score')
+    write_dat(result, moves.length)
+    write_sgf(moves, result)
+  end
+
+  private
+
+  attr_accessor :black, :white, :game
+
+  def play
+    moves = []
+    passes = 0
+    color = 'b'
+    while passes < 2 && moves.length < game['maxmoves'].to_i
+      player, opponent = color == 'b' ? [black, white] : [white, black]
+      move = player.command("genmove #{color}")
+      opponent.command("play #{color} #{move}")
+      moves << move
+      passes = move.casecmp?('pass') ? passes + 1 : 0
+      color = color == 'b' ? 'w' : 'b'
+    end
+    moves
+  end
+
+  def name(ann)
+    File.basename(ann, '.*')
+  end
+
+  def write_dat(result, length)
+    File.open("#{game['prefix']}.dat", 'w') do |f|
+      f.puts "# Black: #{name(game['black'])}"
+      f.puts "# White: #{name(game['white'])}"
+      f.puts '# Referee: evo'
+      f.puts "# Size: #{game['size']}"
+      f.puts "# Komi: #{game['komi']}"
+      f.puts %w[#GAME RES_B RES_W RES_R ALT DUP LEN TIME_B TIME_W CPU_B CPU_W ERR ERR_MSG].join("\t")
+      f.puts ['0', '?', '?', result, '0', '-', length, '0', '0', '0', '0', '0', ''].join("\t")
+    end
+  end
+
+  # GTP vertices like D4 to SGF points like dd, skipping the letter I
+  def sgf_point(move)
+    return '' if move.casecmp?('pass')
+
+    column = 'ABCDEFGHJKLMNOPQRSTUVWXYZ'.index(move[0].upcase)
+    row = game['size'].to_i - move[1..].to_i
+    [column, row].map { |n| ('a'.ord + n).chr }.join
+  end
+
+  def write_sgf(moves, result)
+    File.open("#{game['prefix']}-0.sgf", 'w') do |f|
+      f.print "(;FF[4]CA[UTF-8]GM[1]SZ[#{game['size']}]KM[#{game['komi']}]"
+      f.puts "PB[#{name(game['black'])}]PW[#{name(game['white'])}]RE[#{result}]"
+      moves.each_with_index do |move, i|
+        f.print ";#{i.even? ? 'B' : 'W'}[#{sgf_point(move)}]"
+      end
+      f.puts ')'
+    end
+  end
+end
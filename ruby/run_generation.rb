@@ -6,8 +6,14 @@ class RunGeneration
   def initialize(generation, settings)
     self.generation = generation
     self.settings = settings
-    self.pipe = initialize_pipe
-    self.ractors = initialize_ractors
+    if settings['scheduler']
+      # Games are played on the shared pool of the scheduler daemon
+      self.pipe = SchedulerClient.for(settings['scheduler'], settings['experiment'])
+      self.ractors = []
+    else
+      self.pipe = initialize_pipe
+      self.ractors = initialize_ractors
+    end
 
     trap 'SIGINT' do
       puts 'Stopping ...'
@@ -29,19 +35,27 @@ class RunGeneration
 
   def stop_ractors
     ractors.each { |r| r.send(:stop) }
-    pipe.send(:stop)
+    pipe.send(:stop) unless settings['scheduler']
   end
 
   def initialize_ractors
     settings['concurrency'].to_i.times.map do
       Ractor.new(pipe) do |pipe|
+        # Engines for pooled games, started with the first one
+        engines = nil
         while msg = pipe.take
           if msg == :stop
             puts "[#{Ractor.current}]\tStopping"
+            engines&.each(&:close)
             break
           end
 
-          system(msg['command'])
+          if msg['pooled']
+            engines ||= Array.new(2) { GtpEngine.new('../evo') }
+            PooledGame.call(engines, msg['pooled'])
+          else
+            system(msg['command'])
+          end
           Ractor.yield msg['identifier']
         end
       end
@@ -76,6 +90,7 @@ class RunGeneration
 
   def play_games
     return :already_done if data['round'] >= settings['tournament_rounds'].to_i
+    return play_native_tournament if settings['native_tournament'] && !settings['scheduler']
 
     loop do
       play_round
@@ -86,62 +101,92 @@ class RunGeneration
     puts "\rPlaying ... done".ljust(70)
   end
 
+  # Plays all remaining rounds in one process, see engine/tournament.c
+  def play_native_tournament
+    exit(1) unless system("../tournament --threads #{settings['concurrency']} ../settings.json")
+    @data = nil
+  end
+
   def setup_next_round
+    ranking = Journal.rank(data['ranking'])
     games = if data['round'].succ >= settings['tournament_rounds'].to_i
               []
+            elsif settings['ratings']
+              games_from_ranking(Journal.rank(ratings, 'rating'))
             else
-              games_from_ranking(data['ranking'])
+              games_from_ranking(ranking)
             end
 
     new_data = data.merge(
       'round' => data['round'] + 1,
+      'ranking' => ranking,
       'games' => games
     )
     save_data(new_data)
   end
 
   def play_round
-    # Put all games into the pipe
-    data['games'].each do |game|
+    # Put all games into the pipe. Byes finish right away and leave the list.
+    # Games against external engines go in one batch for engine/twogtp.
+    external = []
+    data['games'].dup.each do |game|
       game_data = prepare_game(game)
       if game_data['winner']
         update_data(game, game_data)
         refresh_progress
+      elsif game_data['external']
+        external << game
       else
         pipe << game_data
       end
     end
+    pipe << external_batch(external) unless external.empty?
 
     loop do
       break if data['games'].empty?
 
-      _r, completed_game = Ractor.select(*ractors)
-      result = score_game(completed_game)
-      update_data(completed_game, result)
-      refresh_progress
+      completed = take_completed_game
+      (completed['batch'] || [completed]).each do |completed_game|
+        result = score_game(completed_game)
+        update_data(completed_game, result)
+        refresh_progress
+      end
+    end
+  end
+
+  # All games of the round with an external engine, played at the same
+  # time by one process
+  def external_batch(games)
+    triples = games.map do |game|
+      black = data['players'][game['black']]['command']
+      white = data['players'][game['white']]['command']
+      %("#{black}" "#{white}" #{prefix_from(game)})
     end
+    cmd = "../twogtp --size #{settings['board_size']} --maxmoves #{settings['max_moves']} " \
+          "--time #{settings['game_length']} --parallel #{settings['concurrency']} #{triples.join(' ')}"
+
+    { 'command' => cmd, 'identifier' => { 'batch' => games } }
+  end
+
+  # The result goes to the journal, the ranking is only sorted for the next round
+  def take_completed_game
+    return pipe.take if settings['scheduler']
+
+    _r, completed_game = Ractor.select(*ractors)
+    completed_game
   end
 
   def update_data(game, result)
-    winner = result['winner']
-    points = result['points'] || 1
-    # Update score
-    new_ranking = data['ranking'].map do |s|
-      if s['name'] == winner
-        s.merge('score' => s['score'] + points)
-      else
-        s
-      end
-    end # .sort_by {|s| -s['score'] }
-    # Group by same score
-    new_ranking = new_ranking.group_by { |s| s['score'] }
-    # Randomize within the same score and flatten again
-    new_ranking = new_ranking.keys.sort.reverse.flat_map { |s| new_ranking[s].shuffle }
-    new_data = data.merge(
-      'games' => data['games'].reject { |g| g == game },
-      'ranking' => new_ranking
-    )
-    save_data(new_data)
+    entry = {
+      'round' => data['round'],
+      'black' => game['black'],
+      'white' => game['white'],
+      'winner' => result['winner'],
+      'points' => result['points'] || 1
+    }
+    Journal.append(entry)
+    Journal.apply(data, entry)
+    exit if $stop_now
   end
 
   def refresh_progress
@@ -160,14 +205,19 @@ class RunGeneration
     # Odd number of players. Received a bye
     return { 'winner' => game['black'], 'points' => 1 } unless game['white']
 
-    black = data['players'][game['black']]['command']
-    white = data['players'][game['white']]['command']
     size = settings['board_size']
     maxmoves = settings['max_moves']
     prefix = prefix_from(game)
-    time = settings['game_length']
-    cmd = %(gogui-twogtp -black "#{black}" -white "#{white}" -referee "gnugo --mode gtp" -size #{size} -auto -games 1 -sgffile #{prefix} -time #{time} -force -maxmoves #{maxmoves})
+    return { 'external' => true } if external?(game['black']) || external?(game['white'])
 
+    if settings['engine_pool'] && !settings['scheduler']
+      pooled = { 'black' => game['black'], 'white' => game['white'], 'size' => size, 'komi' => 6.5,
+                 'maxmoves' => maxmoves, 'prefix' => prefix }
+      return { 'pooled' => pooled, 'identifier' => game }
+    end
+
+    # Both players are nets, play the game in memory
+    cmd = %(../arena --size #{size} --maxmoves #{maxmoves} --round #{data['round']} #{game['black']} #{game['white']})
     { 'command' => cmd, 'identifier' => game }
   end
 
@@ -182,20 +232,20 @@ class RunGeneration
     { 'winner' => winner, 'points' => points }
   end
 
+  def external?(player)
+    data['players'][player]['external']
+  end
+
   def prefix_from(game)
     "#{File.basename(game['black'], '.*')}x#{File.basename(game['white'], '.*')}R#{data['round']}"
   end
 
   def data
-    return {} unless File.exist?('data.json')
-
-    @data ||= JSON.load_file('data.json')
+    @data ||= Journal.load || {}
   end
 
   def save_data(hash)
-    File.open('data.json', 'w') do |f|
-      f.puts JSON.pretty_generate(hash)
-    end
+    Journal.snapshot(hash)
     @data = nil
     exit if $stop_now
   end
@@ -212,20 +262,13 @@ class RunGeneration
     return if data['setup_complete']
 
     previous_generation = generation.to_i - 1
-    previous_data = JSON.load_file("../#{previous_generation}/data.json")
-    # Use the score to determine how "good" the individual is
-    picks = previous_data['ranking'].reject do |player|
-      previous_data['players'][player['name']]['external']
-    end.flat_map do |player|
-      player_name = player['name']
-      # Make better score _much_ more likely to be picked.
-      [player_name] * (player['score']**3)
-    end.compact
+    previous_data = Journal.load("../#{previous_generation}")
+    pick = settings['ratings'] ? pick_by_rating(previous_generation, previous_data) : pick_by_score(previous_data)
     # Generate the new population
     total = settings['population_size'].to_i
     total.times do |i|
       print "\rGenerating population ... #{i + 1}/#{total}"
-      `../evolve #{settings['cross_over_rate']} ../#{previous_generation}/#{picks.sample} ../#{previous_generation}/#{picks.sample}`
+      `../evolve #{settings['cross_over_rate']} ../#{previous_generation}/#{pick.call} ../#{previous_generation}/#{pick.call}`
       FileUtils.mv('child.ann', "#{i}.ann")
     end
     puts "\rGenerating population ... done         "
@@ -233,6 +276,39 @@ class RunGeneration
     save_data(setup_tournament)
   end
 
+  def pick_by_score(previous_data)
+    # Use the score to determine how "good" the individual is
+    picks = previous_data['ranking'].reject do |player|
+      previous_data['players'][player['name']]['external']
+    end.flat_map do |player|
+      player_name = player['name']
+      # Make better score _much_ more likely to be picked.
+      [player_name] * (player['score']**3)
+    end.compact
+    -> { picks.sample }
+  end
+
+  # Thompson sampling: draw a rating for every net from its confidence
+  # interval and pick the best, so nets with few games still get a chance
+  def pick_by_rating(previous_generation, previous_data)
+    candidates = ratings("../#{previous_generation}").reject do |player|
+      previous_data['players'][player['name']]['external']
+    end
+    lambda do
+      candidates.max_by do |player|
+        player['rating'] + (player['deviation'] * Math.sqrt(-2 * Math.log(1 - rand)) * Math.cos(2 * Math::PI * rand))
+      end['name']
+    end
+  end
+
+  # Glicko-2 ratings from the journal of the generation in dir, see engine/ratings
+  def ratings(dir = '.')
+    `../ratings #{dir}`.lines.map do |line|
+      name, rating, deviation, _volatility, games = line.split
+      { 'name' => name, 'rating' => rating.to_f, 'deviation' => deviation.to_f, 'games' => games.to_i }
+    end
+  end
+
   def clean_up_generation(g)
     Dir.chdir("../#{g}") do
       # stdout, stderr, status = Open3.capture3('find . -name "*.ann" -print | tar cvfj anns.tar.bz2 -T -')
@@ -250,8 +326,11 @@ class RunGeneration
 
   AMIGO = { 'name' => 'AmiGo', 'command' => 'amigogtp', 'points' => 10 }
   BROWN = { 'name' => 'Brown', 'command' => 'brown', 'points' => 1 }
-  GNUGO0 = { 'name' => 'GnuGoLevel0', 'command' => 'gnugo --level 0 --mode gtp', 'points' => 50 }
-  GNUGO10 = { 'name' => 'GnuGoLevel10', 'command' => 'gnugo --level 10 --mode gtp', 'points' => 100 }
+  # GnuGo with a fixed seed always answers the same, so its moves are cached
+  # for the whole experiment by engine/gtpcache
+  GNUGO = '../gtpcache --cache ../gtp.cache gnugo --mode gtp --seed 1'
+  GNUGO0 = { 'name' => 'GnuGoLevel0', 'command' => "#{GNUGO} --level 0", 'points' => 50 }
+  GNUGO10 = { 'name' => 'GnuGoLevel10', 'command' => "#{GNUGO} --level 10", 'points' => 100 }
   EXTERNAL_PLAYERS = [
     *(1..5).map { |i| BROWN.merge('name' => BROWN['name'] + i.to_s) },
     *(1..10).map { |i| AMIGO.merge('name' => AMIGO['name'] + i.to_s) },
@@ -0,0 +1,230 @@
+require 'json'
+require 'socket'
+
+# One pool of workers for the games of several experiments. Every
+# experiment has its own runner, started with `./runner NAME scheduler`,
+# which sends its games here instead of playing them on its own workers.
+# While one experiment waits for the last games of a round, the workers
+# play the games of the others.
+#
+# Free workers go to the experiment with the least use of the pool for
+# its weight. An experiment is charged the mean length of its games when
+# one starts and the difference to the real length when it ends, so a
+# burst of games from one runner cannot take over the pool.
+#
+# Runners and ./scheduler talk to it over a UNIX socket, one JSON object
+# per line.
+class Scheduler
+  Experiment = Struct.new(:name, :weight, :queue, :running, :done, :usage, :mean, :client, :pid)
+
+  def self.call(path, workers, experiments)
+    new(path, workers).call(experiments)
+  end
+
+  def initialize(path, workers)
+    self.path = path
+    self.workers = workers
+    self.experiments = {}
+    self.lock = Mutex.new
+    self.ready = ConditionVariable.new
+  end
+
+  def call(initial)
+    File.delete(path) if File.exist?(path)
+    server = UNIXServer.new(path)
+    trap('SIGINT') { Thread.new { stop } }
+    initial.each { |name, weight| add('name' => name, 'weight' => weight) }
+    workers.times { Thread.new { work } }
+    puts "Scheduling on #{workers} workers at #{path}"
+    loop { Thread.new(server.accept) { |client| serve(client) } }
+  ensure
+    File.delete(path) if File.exist?(path)
+  end
+
+  private
+
+  attr_accessor :path, :workers, :experiments, :lock, :ready
+
+  def serve(client)
+    writer = Mutex.new
+    experiment = nil
+    while (line = client.gets)
+      msg = JSON.parse(line)
+      reply = case msg['command']
+              when 'register'
+                experiment = register(msg['name'], client, writer)
+                nil
+              when 'job' then submit(experiment, msg['job'])
+              else control(msg)
+              end
+      writer.synchronize { client.puts(JSON.generate(reply)) } if reply
+      stop if msg['command'] == 'stop'
+    end
+  rescue IOError, SystemCallError
+    nil
+  ensure
+    disconnect(experiment) if experiment
+    client.close
+  end
+
+  def control(msg)
+    case msg['command']
+    when 'add' then add(msg)
+    when 'remove' then remove(msg['name'])
+    when 'weight' then set_weight(msg['name'], msg['weight'])
+    when 'status' then status
+    when 'stop' then { 'ok' => true }
+    else { 'error' => 'unknown command' }
+    end
+  end
+
+  # Starts the runner of an experiment, unless it is running already
+  def add(msg)
+    name = msg['name']
+    return { 'error' => "#{name} is no experiment" } unless File.exist?("experiments/#{name}/settings.json")
+
+    lock.synchronize do
+      experiment = find_or_create(name)
+      experiment.weight = msg['weight'].to_f if msg['weight']
+      unless experiment.pid || experiment.client
+        log = File.open("experiments/#{name}/runner.log", 'a')
+        pid = spawn('./runner', name, 'scheduler', out: log, err: log)
+        log.close
+        experiment.pid = pid
+        Thread.new do
+          Process.wait(pid)
+          lock.synchronize { experiment.pid = nil if experiment.pid == pid }
+        end
+      end
+    end
+    { 'ok' => true }
+  end
+
+  # Stops the runner of an experiment. Its queued games are dropped, the
+  # journal of its generation has everything to continue later.
+  def remove(name)
+    lock.synchronize do
+      experiment = experiments[name]
+      return { 'error' => "#{name} is not scheduled" } unless experiment
+
+      experiment.queue.clear
+      Process.kill('SIGINT', experiment.pid) if experiment.pid
+      experiment.client&.first&.close
+      experiments.delete(name)
+    end
+    { 'ok' => true }
+  end
+
+  def set_weight(name, value)
+    lock.synchronize do
+      return { 'error' => "#{name} is not scheduled" } unless experiments[name]
+
+      experiments[name].weight = value.to_f
+    end
+    { 'ok' => true }
+  end
+
+  def status
+    lock.synchronize do
+      {
+        'workers' => workers,
+        'experiments' => experiments.values.map do |e|
+          { 'name' => e.name, 'weight' => e.weight, 'queued' => e.queue.length, 'running' => e.running,
+            'done' => e.done, 'usage' => e.usage.round(1) }
+        end
+      }
+    end
+  end
+
+  def stop
+    lock.synchronize do
+      experiments.each_value { |e| Process.kill('SIGINT', e.pid) if e.pid }
+    end
+    puts 'Stopping ...'
+    File.delete(path) if File.exist?(path)
+    exit!(0)
+  end
+
+  def register(name, client, writer)
+    lock.synchronize do
+      experiment = find_or_create(name)
+      experiment.client = [client, writer]
+      experiment
+    end
+  end
+
+  def disconnect(experiment)
+    lock.synchronize do
+      experiment.client = nil
+      experiment.pid = nil
+      experiment.queue.clear
+      forget(experiment) if experiment.running.zero?
+    end
+  end
+
+  # Called with the lock held. The name may belong to a new experiment
+  # by now, after a remove and an add.
+  def forget(experiment)
+    experiments.delete(experiment.name) if experiments[experiment.name].equal?(experiment)
+  end
+
+  # A new experiment starts level with the others, not with their history
+  def find_or_create(name)
+    experiments[name] ||= begin
+      share = experiments.values.map { |e| e.usage / e.weight }.min || 0
+      Experiment.new(name, 1.0, [], 0, 0, share, 1.0, nil, nil)
+    end
+  end
+
+  def submit(experiment, job)
+    return { 'error' => 'not registered' } unless experiment
+
+    lock.synchronize do
+      experiment.queue << job
+      ready.signal
+    end
+    nil
+  end
+
+  # Called with the lock held
+  def next_job
+    experiment = experiments.values.reject { |e| e.queue.empty? }.min_by { |e| e.usage / e.weight }
+    return nil unless experiment
+
+    experiment.running += 1
+    experiment.usage += experiment.mean
+    [experiment, experiment.queue.shift, experiment.mean]
+  end
+
+  def work
+    loop do
+      experiment, job, estimate = lock.synchronize do
+        ready.wait(lock) until (picked = next_job)
+        picked
+      end
+
+      start = Process.clock_gettime(Process::CLOCK_MONOTONIC)
+      system(job['command'], chdir: job['dir'])
+      seconds = Process.clock_gettime(Process::CLOCK_MONOTONIC) - start
+
+      finished(experiment, job, estimate, seconds)
+    end
+  end
+
+  def finished(experiment, job, estimate, seconds)
+    client = lock.synchronize do
+      experiment.running -= 1
+      experiment.done += 1
+      experiment.usage += seconds - estimate
+      experiment.mean += (seconds - experiment.mean) / [experiment.done, 20].min
+      forget(experiment) if experiment.client.nil? && experiment.pid.nil? && experiment.running.zero?
+      experiment.client
+    end
+    return unless client
+
+    socket, writer = client
+    writer.synchronize { socket.puts(JSON.generate('done' => job['identifier'])) }
+  rescue IOError, SystemCallError
+    nil
+  end
+end
@@ -0,0 +1,48 @@
+require 'json'
+require 'socket'
+
+# A connection to the scheduler daemon, see Scheduler. A runner submits
+# its games with << and takes back their identifiers when they are done,
+# the way it uses its own pipe and ractors otherwise.
+class SchedulerClient
+  # One connection per process, kept from generation to generation
+  def self.for(path, name)
+    @clients ||= {}
+    @clients[path] ||= new(path).tap { |client| client.register(name) }
+  end
+
+  def initialize(path)
+    self.socket = UNIXSocket.new(path)
+  end
+
+  def register(name)
+    send_message('command' => 'register', 'name' => name)
+  end
+
+  # The game is played in the directory it was submitted from
+  def <<(game_data)
+    send_message('command' => 'job', 'job' => game_data.merge('dir' => Dir.pwd))
+  end
+
+  # The identifier of the next game that is done
+  def take
+    line = socket.gets
+    abort 'The scheduler went away' unless line
+
+    JSON.parse(line)['done']
+  end
+
+  # For ./scheduler, sends a command and returns the reply
+  def request(msg)
+    send_message(msg)
+    JSON.parse(socket.gets || '{"error": "no reply"}')
+  end
+
+  private
+
+  attr_accessor :socket
+
+  def send_message(msg)
+    socket.puts(JSON.generate(msg))
+  end
+end
@@ -12,7 +12,7 @@ class SetupExperiment
 
   def self.setup_directory(experiment_dir)
     FileUtils.mkdir_p(experiment_dir)
-    executables = ["engine/evo", "initial-population/initial-population", "evolve/evolve"].map {|e| File.expand_path(e)}
+    executables = ["engine/evo", "engine/arena", "engine/tournament", "engine/ratings", "engine/twogtp", "engine/gtpcache", "initial-population/initial-population", "evolve/evolve", "autotune/autotune"].map {|e| File.expand_path(e)}
     FileUtils.ln_s(executables, experiment_dir, force: true)
   end
 